@@ -1,9 +1,11 @@
 #include "advisers.h"
+#include "lazy_database.h"
 
 namespace PyMKF {
 
 json calculate_advised_cores(json inputsJson, json weightsJson, int maximumNumberResults, json coreModeJson) {
     try {
+        materialize_all_records();
         OpenMagnetics::Inputs inputs(inputsJson);
         OpenMagnetics::CoreAdviser::CoreAdviserModes coreMode;
         from_json(coreModeJson, coreMode);
@@ -43,6 +45,7 @@ json calculate_advised_cores(json inputsJson, json weightsJson, int maximumNumbe
 
 json calculate_advised_magnetics(json inputsJson, int maximumNumberResults, json coreModeJson) {
     try {
+        materialize_all_records();
         OpenMagnetics::Inputs inputs(inputsJson);
         OpenMagnetics::CoreAdviser::CoreAdviserModes coreMode;
         from_json(coreModeJson, coreMode);
@@ -69,6 +72,7 @@ json calculate_advised_magnetics(json inputsJson, int maximumNumberResults, json
 
 json calculate_advised_magnetics_from_catalog(json inputsJson, json catalogJson, int maximumNumberResults) {
     try {
+        materialize_all_records();
         OpenMagnetics::settings->set_coil_delimit_and_compact(true);
         OpenMagnetics::Inputs inputs(inputsJson);
         std::map<OpenMagnetics::MagneticFilters, double> weights;
@@ -113,6 +117,7 @@ json calculate_advised_magnetics_from_catalog(json inputsJson, json catalogJson,
 
 json calculate_advised_magnetics_from_cache(json inputsJson, json filterFlowJson, int maximumNumberResults) {
     try {
+        materialize_all_records();
         OpenMagnetics::settings->set_coil_delimit_and_compact(true);
         OpenMagnetics::Inputs inputs(inputsJson);
 
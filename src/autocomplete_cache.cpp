@@ -0,0 +1,232 @@
+#include "autocomplete_cache.h"
+#include "database.h"
+#include "ndjson.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifndef MAS_REVISION
+#define MAS_REVISION unknown
+#endif
+#ifndef MKF_REVISION
+#define MKF_REVISION unknown
+#endif
+
+namespace PyMKF {
+
+namespace {
+
+constexpr const char* autocompleteCacheExtension = ".msgpack";
+
+std::mutex autocompleteCacheMutex;
+std::filesystem::path autocompleteCacheDirectory;
+size_t autocompleteCacheMaximumBytes = 0;
+std::atomic<size_t> autocompleteCacheBytes{0};
+std::atomic<uint64_t> autocompleteCacheHits{0};
+std::atomic<uint64_t> autocompleteCacheMisses{0};
+std::atomic<uint64_t> autocompleteCacheWrites{0};
+std::atomic<uint64_t> autocompleteCacheEvictions{0};
+
+std::filesystem::path get_entry_path(const std::filesystem::path& directory, const std::string& canonicalInput) {
+    std::string revisions = MACRO_STRINGIFY(MAS_REVISION) "/" MACRO_STRINGIFY(MKF_REVISION) "/" + std::to_string(get_database_fingerprint()) + "\n";
+    std::ostringstream key;
+    key << std::hex;
+    key.width(16);
+    key.fill('0');
+    key << hash_text(canonicalInput, hash_text(revisions));
+    auto name = key.str();
+    return directory / name.substr(0, 2) / (name + autocompleteCacheExtension);
+}
+
+struct CacheEntryFile {
+    std::filesystem::path path;
+    std::filesystem::file_time_type lastUse;
+    size_t bytes;
+};
+
+std::vector<CacheEntryFile> list_entries(const std::filesystem::path& directory) {
+    std::vector<CacheEntryFile> entries;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (!it->is_regular_file() || it->path().extension() != autocompleteCacheExtension) {
+            continue;
+        }
+        std::error_code entryError;
+        auto lastUse = it->last_write_time(entryError);
+        auto bytes = it->file_size(entryError);
+        if (!entryError) {
+            entries.push_back({it->path(), lastUse, static_cast<size_t>(bytes)});
+        }
+    }
+    return entries;
+}
+
+size_t count_bytes(const std::vector<CacheEntryFile>& entries) {
+    size_t bytes = 0;
+    for (auto& entry : entries) {
+        bytes += entry.bytes;
+    }
+    return bytes;
+}
+
+// Caller must hold autocompleteCacheMutex
+void evict_entries() {
+    // Evict down to 7/8 of the cap so a full cache does not rescan the directory on every write
+    auto entries = list_entries(autocompleteCacheDirectory);
+    size_t bytes = count_bytes(entries);
+    size_t target = autocompleteCacheMaximumBytes - autocompleteCacheMaximumBytes / 8;
+    std::sort(entries.begin(), entries.end(), [](const CacheEntryFile& a, const CacheEntryFile& b) {
+        return a.lastUse < b.lastUse;
+    });
+    for (auto& entry : entries) {
+        if (bytes <= target) {
+            break;
+        }
+        std::error_code error;
+        if (std::filesystem::remove(entry.path, error)) {
+            bytes -= entry.bytes;
+            autocompleteCacheEvictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    autocompleteCacheBytes.store(bytes);
+}
+
+std::optional<json> read_entry(const std::filesystem::path& path, const std::string& canonicalInput) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    try {
+        auto entry = json::from_msgpack(data);
+        // The full input is stored, so a hash collision is a miss rather than a wrong magnetic
+        if (entry.at("input").get_ref<const std::string&>() != canonicalInput) {
+            return std::nullopt;
+        }
+        return entry.at("magnetic");
+    }
+    catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+void write_entry(const std::filesystem::path& path, const std::string& canonicalInput, const OpenMagnetics::Magnetic& magnetic, size_t maximumBytes) {
+    json entry;
+    entry["input"] = canonicalInput;
+    to_json(entry["magnetic"], magnetic);
+    auto data = json::to_msgpack(entry);
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    auto temporaryPath = path;
+    // Unique per process and thread, as several workers may share the cache directory
+    temporaryPath += ".tmp" + std::to_string(get_process_id()) + "-" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!file) {
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return;
+    }
+    autocompleteCacheWrites.fetch_add(1, std::memory_order_relaxed);
+    if (autocompleteCacheBytes.fetch_add(data.size()) + data.size() > maximumBytes) {
+        std::lock_guard<std::mutex> lock(autocompleteCacheMutex);
+        if (autocompleteCacheBytes.load() > autocompleteCacheMaximumBytes) {
+            evict_entries();
+        }
+    }
+}
+
+} // namespace
+
+std::string set_autocomplete_cache_directory(std::string directory, size_t maximumBytes) {
+    try {
+        std::lock_guard<std::mutex> lock(autocompleteCacheMutex);
+        if (!directory.empty()) {
+            std::filesystem::create_directories(directory);
+        }
+        autocompleteCacheDirectory = directory;
+        autocompleteCacheMaximumBytes = maximumBytes;
+        autocompleteCacheBytes.store(directory.empty() ? 0 : count_bytes(list_entries(autocompleteCacheDirectory)));
+        if (autocompleteCacheBytes.load() > autocompleteCacheMaximumBytes) {
+            evict_entries();
+        }
+        return "0";
+    }
+    catch (const std::exception &exc) {
+        return "Exception: " + std::string{exc.what()};
+    }
+}
+
+OpenMagnetics::Magnetic autocomplete_magnetic(const OpenMagnetics::Magnetic& magnetic) {
+    std::filesystem::path directory;
+    size_t maximumBytes;
+    {
+        std::lock_guard<std::mutex> lock(autocompleteCacheMutex);
+        directory = autocompleteCacheDirectory;
+        maximumBytes = autocompleteCacheMaximumBytes;
+    }
+    if (directory.empty()) {
+        return OpenMagnetics::magnetic_autocomplete(magnetic);
+    }
+
+    json input;
+    to_json(input, magnetic);
+    auto canonicalInput = input.dump();
+    auto path = get_entry_path(directory, canonicalInput);
+    if (auto cached = read_entry(path, canonicalInput)) {
+        autocompleteCacheHits.fetch_add(1, std::memory_order_relaxed);
+        std::error_code error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+        return OpenMagnetics::Magnetic(cached.value());
+    }
+
+    autocompleteCacheMisses.fetch_add(1, std::memory_order_relaxed);
+    auto expanded = OpenMagnetics::magnetic_autocomplete(magnetic);
+    // Best effort, a full disk or a read-only directory only costs the next load its speedup
+    write_entry(path, canonicalInput, expanded, maximumBytes);
+    return expanded;
+}
+
+std::string clear_autocomplete_cache() {
+    try {
+        std::lock_guard<std::mutex> lock(autocompleteCacheMutex);
+        if (!autocompleteCacheDirectory.empty()) {
+            for (auto& entry : list_entries(autocompleteCacheDirectory)) {
+                std::filesystem::remove(entry.path);
+            }
+        }
+        autocompleteCacheBytes.store(0);
+        return "0";
+    }
+    catch (const std::exception &exc) {
+        return "Exception: " + std::string{exc.what()};
+    }
+}
+
+json get_autocomplete_cache_statistics() {
+    std::lock_guard<std::mutex> lock(autocompleteCacheMutex);
+    json statistics;
+    statistics["directory"] = autocompleteCacheDirectory.string();
+    statistics["enabled"] = !autocompleteCacheDirectory.empty();
+    statistics["bytes"] = autocompleteCacheBytes.load();
+    statistics["maximumBytes"] = autocompleteCacheMaximumBytes;
+    statistics["hits"] = autocompleteCacheHits.load();
+    statistics["misses"] = autocompleteCacheMisses.load();
+    statistics["writes"] = autocompleteCacheWrites.load();
+    statistics["evictions"] = autocompleteCacheEvictions.load();
+    return statistics;
+}
+
+} // namespace PyMKF
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "common.h"
+
+namespace PyMKF {
+
+// Persistent cache of autocompleted magnetics. Entries are keyed by a hash of the canonical
+// magnetic JSON, the MAS and MKF revisions the module was built with and the fingerprint of the
+// loaded databases, so neither a rebuild against newer models nor custom or reloaded data ever
+// reuses stale expansions.
+
+// Enables the cache in directory, keeping it under maximumBytes by deleting the least recently
+// used entries. An empty directory disables it.
+std::string set_autocomplete_cache_directory(std::string directory, size_t maximumBytes);
+
+// OpenMagnetics::magnetic_autocomplete, served from the cache when enabled. Safe to call from
+// several threads at once.
+OpenMagnetics::Magnetic autocomplete_magnetic(const OpenMagnetics::Magnetic& magnetic);
+
+std::string clear_autocomplete_cache();
+json get_autocomplete_cache_statistics();
+
+} // namespace PyMKF
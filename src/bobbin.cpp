@@ -1,9 +1,11 @@
 #include "bobbin.h"
+#include "lazy_database.h"
 
 namespace PyMKF {
 
 json get_bobbins() {
     try {
+        materialize_all_records();
         auto bobbins = OpenMagnetics::get_bobbins();
         json result = json::array();
         for (auto elem : bobbins) {
@@ -22,6 +24,7 @@ json get_bobbins() {
 
 json get_bobbin_names() {
     try {
+        materialize_all_records();
         auto bobbinNames = OpenMagnetics::get_bobbin_names();
         json result = json::array();
         for (auto elem : bobbinNames) {
@@ -38,6 +41,7 @@ json get_bobbin_names() {
 
 json find_bobbin_by_name(json bobbinName) {
     try {
+        materialize_references(bobbinName);
         auto bobbinData = OpenMagnetics::find_bobbin_by_name(bobbinName);
         json result;
         to_json(result, bobbinData);
@@ -52,6 +56,7 @@ json find_bobbin_by_name(json bobbinName) {
 
 json create_basic_bobbin(json coreDataJson, bool nullDimensions) {
     try {
+        materialize_references(coreDataJson);
         OpenMagnetics::Core core(coreDataJson, false, false, false);
         auto bobbin = OpenMagnetics::Bobbin::create_quick_bobbin(core, nullDimensions);
 
@@ -68,6 +73,7 @@ json create_basic_bobbin(json coreDataJson, bool nullDimensions) {
 
 json create_basic_bobbin_by_thickness(json coreDataJson, double thickness) {
     try {
+        materialize_references(coreDataJson);
         OpenMagnetics::Core core(coreDataJson, false, false, false);
         auto bobbin = OpenMagnetics::Bobbin::create_quick_bobbin(core, thickness);
 
@@ -84,6 +90,7 @@ json create_basic_bobbin_by_thickness(json coreDataJson, double thickness) {
 
 json calculate_bobbin_data(json magneticJson) {
     try {
+        materialize_references(magneticJson);
         OpenMagnetics::Magnetic magnetic(magneticJson);
 
         auto optionalBobbin = magnetic.get_coil().get_bobbin();
@@ -111,6 +118,7 @@ json calculate_bobbin_data(json magneticJson) {
 
 json process_bobbin(json bobbinJson) {
     try {
+        materialize_references(bobbinJson);
         OpenMagnetics::Bobbin bobbin(bobbinJson);
         bobbin.process_data();
 
@@ -125,6 +133,7 @@ json process_bobbin(json bobbinJson) {
 
 bool check_if_fits(json bobbinJson, double dimension, bool isHorizontalOrRadial) {
     try {
+        materialize_references(bobbinJson);
         OpenMagnetics::Bobbin bobbin(bobbinJson);
         return bobbin.check_if_fits(dimension, isHorizontalOrRadial);
     }
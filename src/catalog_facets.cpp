@@ -0,0 +1,160 @@
+#include "catalog_facets.h"
+#include "core_catalog.h"
+#include "database.h"
+#include "lazy_database.h"
+#include <array>
+#include <mutex>
+#include <set>
+
+namespace PyMKF {
+
+namespace {
+
+std::mutex catalogNamesMutex;
+std::shared_ptr<const CatalogNames> currentCatalogNames;
+uint64_t catalogNamesDatabaseVersion = 0;
+std::array<size_t, 2> catalogNamesDatabaseSizes{};
+
+std::mutex catalogFacetsMutex;
+json currentCatalogFacets;
+uint64_t catalogFacetsDatabaseVersion = 0;
+std::array<size_t, 3> catalogFacetsDatabaseSizes{};
+
+std::array<size_t, 3> get_database_sizes() {
+    return {OpenMagnetics::coreMaterialDatabase.size(), OpenMagnetics::coreShapeDatabase.size(), OpenMagnetics::coreDatabase.size()};
+}
+
+std::string get_family_name(const CoreShapeFamily& family) {
+    json familyJson;
+    to_json(familyJson, family);
+    return familyJson.get<std::string>();
+}
+
+std::shared_ptr<const CatalogNames> build_catalog_names() {
+    auto names = std::make_shared<CatalogNames>();
+    std::set<std::string> listedManufacturers;
+    for (auto& material : OpenMagnetics::get_materials("")) {
+        auto manufacturer = material.get_manufacturer_info().get_name();
+        if (listedManufacturers.insert(manufacturer).second) {
+            names->manufacturers.push_back(manufacturer);
+        }
+    }
+    names->shapeFamilies = json::array();
+    std::set<std::string> listedFamilies;
+    for (auto& shape : OpenMagnetics::get_shapes(false)) {
+        auto family = get_family_name(shape.get_family());
+        if (listedFamilies.insert(family).second) {
+            names->shapeFamilies.push_back(family);
+        }
+    }
+    return names;
+}
+
+json build_catalog_facets() {
+    auto names = get_catalog_names();
+
+    std::map<std::string, std::vector<std::string>> materialsByManufacturer;
+    std::map<std::string, std::string> manufacturerByMaterial;
+    for (auto& material : OpenMagnetics::get_materials("")) {
+        auto manufacturer = material.get_manufacturer_info().get_name();
+        materialsByManufacturer[manufacturer].push_back(material.get_name());
+        manufacturerByMaterial[material.get_name()] = manufacturer;
+    }
+
+    std::map<std::string, std::vector<std::string>> shapesByFamily;
+    for (auto& shape : OpenMagnetics::get_shapes(true)) {
+        shapesByFamily[get_family_name(shape.get_family())].push_back(shape.get_name().value_or(""));
+    }
+
+    auto catalog = get_core_catalog();
+    std::map<std::string, size_t> coresByManufacturer;
+    std::map<std::string, size_t> coresByFamily;
+    std::map<std::string, size_t> coresByMaterial;
+    for (size_t row = 0; row < catalog->size(); ++row) {
+        ++coresByManufacturer[catalog->manufacturerNames[catalog->manufacturerIds[row]]];
+        ++coresByFamily[catalog->familyNames[catalog->familyIds[row]]];
+        ++coresByMaterial[catalog->materialNames[catalog->materialIds[row]]];
+    }
+    auto count = [](const std::map<std::string, size_t>& counts, const std::string& name) {
+        auto found = counts.find(name);
+        return found == counts.end() ? size_t{0} : found->second;
+    };
+
+    json result;
+    result["manufacturers"] = json::array();
+    for (auto& manufacturer : names->manufacturers) {
+        json facet;
+        facet["name"] = manufacturer;
+        facet["materials"] = materialsByManufacturer[manufacturer].size();
+        facet["cores"] = count(coresByManufacturer, manufacturer);
+        result["manufacturers"].push_back(facet);
+    }
+    result["families"] = json::array();
+    for (auto& [family, shapes] : shapesByFamily) {
+        json facet;
+        facet["name"] = family;
+        facet["shapes"] = shapes.size();
+        facet["cores"] = count(coresByFamily, family);
+        result["families"].push_back(facet);
+    }
+    result["materials"] = json::array();
+    for (auto& [material, manufacturer] : manufacturerByMaterial) {
+        json facet;
+        facet["name"] = material;
+        facet["manufacturer"] = manufacturer;
+        facet["cores"] = count(coresByMaterial, material);
+        result["materials"].push_back(facet);
+    }
+    result["materialsByManufacturer"] = materialsByManufacturer;
+    result["shapesByFamily"] = shapesByFamily;
+    size_t numberShapes = 0;
+    for (auto& [family, shapes] : shapesByFamily) {
+        numberShapes += shapes.size();
+    }
+    result["counts"]["manufacturers"] = names->manufacturers.size();
+    result["counts"]["families"] = shapesByFamily.size();
+    result["counts"]["materials"] = manufacturerByMaterial.size();
+    result["counts"]["shapes"] = numberShapes;
+    result["counts"]["cores"] = catalog->size();
+    return result;
+}
+
+} // namespace
+
+std::shared_ptr<const CatalogNames> get_catalog_names() {
+    std::lock_guard<std::mutex> lock(catalogNamesMutex);
+    materialize_all_records();
+    ensure_core_databases_loaded();
+    std::array<size_t, 2> databaseSizes{OpenMagnetics::coreMaterialDatabase.size(), OpenMagnetics::coreShapeDatabase.size()};
+    if (currentCatalogNames && catalogNamesDatabaseVersion == get_database_version() && catalogNamesDatabaseSizes == databaseSizes) {
+        return currentCatalogNames;
+    }
+    catalogNamesDatabaseVersion = get_database_version();
+    catalogNamesDatabaseSizes = databaseSizes;
+    currentCatalogNames = build_catalog_names();
+    return currentCatalogNames;
+}
+
+json get_catalog_facets() {
+    try {
+        std::lock_guard<std::mutex> lock(catalogFacetsMutex);
+        materialize_all_records();
+        ensure_core_databases_loaded();
+        if (OpenMagnetics::coreDatabase.empty()) {
+            OpenMagnetics::load_cores();
+        }
+        if (currentCatalogFacets.is_null() || catalogFacetsDatabaseVersion != get_database_version() || catalogFacetsDatabaseSizes != get_database_sizes()) {
+            currentCatalogFacets = build_catalog_facets();
+            catalogFacetsDatabaseVersion = get_database_version();
+            catalogFacetsDatabaseSizes = get_database_sizes();
+        }
+        return currentCatalogFacets;
+    }
+    catch (const std::exception &exc) {
+        json exception;
+        exception["data"] = "Exception: " + std::string{exc.what()};
+        return exception;
+    }
+}
+
+} // namespace PyMKF
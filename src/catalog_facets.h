@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.h"
+#include <memory>
+
+namespace PyMKF {
+
+// Manufacturers and shape families of the material and shape databases, built once per database
+// version. The core database is neither loaded nor read.
+struct CatalogNames {
+    // As get_available_core_manufacturers lists them, in material database order
+    std::vector<std::string> manufacturers;
+    // As get_core_shape_families lists them, one serialized family per entry
+    json shapeFamilies;
+};
+
+// Rebuilt the first time it is requested after a load, reload or clear. The returned pointer
+// stays valid for the caller even if the databases change.
+std::shared_ptr<const CatalogNames> get_catalog_names();
+
+// Manufacturers, shape families, materials per manufacturer and shapes per family, with how many
+// materials, shapes and cores fall under each. Loads the core database to count the cores.
+json get_catalog_facets();
+
+} // namespace PyMKF
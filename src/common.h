@@ -41,10 +41,3 @@ namespace py = pybind11;
 
 #define STRINGIFY(x) #x
 #define MACRO_STRINGIFY(x) STRINGIFY(x)
-
-namespace PyMKF {
-
-// Global database declaration - defined in module.cpp
-extern std::map<std::string, OpenMagnetics::Mas> masDatabase;
-
-} // namespace PyMKF
@@ -1,9 +1,20 @@
 #include "core.h"
+#include "catalog_facets.h"
+#include "core_catalog.h"
+#include "core_energy_map.h"
+#include "core_processing_cache.h"
+#include "database.h"
+#include "gap_solver.h"
+#include "lazy_database.h"
+#include "material_surface.h"
+#include "parallel.h"
+#include <pybind11/numpy.h>
 
 namespace PyMKF {
 
 json get_core_materials() {
     try {
+        materialize_all_records();
         auto materials = OpenMagnetics::get_materials(std::nullopt);
         json result = json::array();
         for (auto elem: materials) {
@@ -22,6 +33,14 @@ json get_core_materials() {
 
 double get_material_permeability(json materialName, double temperature, double magneticFieldDcBias, double frequency) {
     try {
+        if (auto surface = get_material_surface(materialName)) {
+            if (auto permeability = surface->get_permeability(temperature, magneticFieldDcBias, frequency)) {
+                record_material_surface_queries(1, 0);
+                return *permeability;
+            }
+            record_material_surface_queries(0, 1);
+        }
+        materialize_references(materialName);
         auto materialData = OpenMagnetics::find_core_material_by_name(materialName);
         OpenMagnetics::InitialPermeability initialPermeability;
         return initialPermeability.get_initial_permeability(materialData, temperature, magneticFieldDcBias, frequency);
@@ -31,8 +50,61 @@ double get_material_permeability(json materialName, double temperature, double m
     }
 }
 
+py::array_t<double> get_material_permeability_batch(json materialName, py::array_t<double> temperatures, py::array_t<double> magneticFieldDcBiases, py::array_t<double> frequencies) {
+    try {
+        materialize_references(materialName);
+        auto materialData = OpenMagnetics::find_core_material_by_name(materialName);
+        auto surface = get_material_surface(materialName);
+
+        // NumPy broadcasting rules; contiguous copies of the broadcast views keep the loop below flat
+        using ContiguousArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+        auto broadcast = py::module_::import("numpy").attr("broadcast_arrays")(temperatures, magneticFieldDcBiases, frequencies);
+        auto temperature = broadcast[py::int_(0)].cast<ContiguousArray>();
+        auto magneticFieldDcBias = broadcast[py::int_(1)].cast<ContiguousArray>();
+        auto frequency = broadcast[py::int_(2)].cast<ContiguousArray>();
+
+        std::vector<py::ssize_t> shape(temperature.shape(), temperature.shape() + temperature.ndim());
+        py::array_t<double> result(shape);
+        const double* temperatureData = temperature.data();
+        const double* magneticFieldDcBiasData = magneticFieldDcBias.data();
+        const double* frequencyData = frequency.data();
+        double* resultData = result.mutable_data();
+        py::ssize_t size = result.size();
+        {
+            py::gil_scoped_release release;
+            OpenMagnetics::InitialPermeability initialPermeability;
+            size_t hits = 0;
+            for (py::ssize_t index = 0; index < size; ++index) {
+                if (surface) {
+                    if (auto permeability = surface->get_permeability(temperatureData[index], magneticFieldDcBiasData[index], frequencyData[index])) {
+                        resultData[index] = *permeability;
+                        ++hits;
+                        continue;
+                    }
+                }
+                resultData[index] = initialPermeability.get_initial_permeability(materialData, temperatureData[index], magneticFieldDcBiasData[index], frequencyData[index]);
+            }
+            if (surface) {
+                record_material_surface_queries(hits, size - hits);
+            }
+        }
+        return result;
+    }
+    catch (const std::exception &exc) {
+        throw std::runtime_error("Exception: " + std::string{exc.what()});
+    }
+}
+
 double get_material_resistivity(json materialName, double temperature) {
     try {
+        if (auto surface = get_material_surface(materialName)) {
+            if (auto resistivity = surface->get_resistivity(temperature)) {
+                record_material_surface_queries(1, 0);
+                return *resistivity;
+            }
+            record_material_surface_queries(0, 1);
+        }
+        materialize_references(materialName);
         auto materialData = OpenMagnetics::find_core_material_by_name(materialName);
         auto resistivityModel = OpenMagnetics::ResistivityModel::factory(OpenMagnetics::ResistivityModels::CORE_MATERIAL);
         return (*resistivityModel).get_resistivity(materialData, temperature);
@@ -44,6 +116,10 @@ double get_material_resistivity(json materialName, double temperature) {
 
 json get_core_material_steinmetz_coefficients(json materialName, double frequency) {
     try {
+        if (auto surface = get_material_surface(materialName)) {
+            return surface->get_steinmetz_coefficients(materialName, frequency);
+        }
+        materialize_references(materialName);
         auto steinmetzCoreLossesMethodRangeDatum = OpenMagnetics::CoreLossesModel::get_steinmetz_coefficients(materialName, frequency);
         json result;
         to_json(result, steinmetzCoreLossesMethodRangeDatum);
@@ -58,6 +134,7 @@ json get_core_material_steinmetz_coefficients(json materialName, double frequenc
 
 json get_core_shapes() {
     try {
+        materialize_all_records();
         auto shapes = OpenMagnetics::get_shapes(true);
         json result = json::array();
         for (auto elem : shapes) {
@@ -76,19 +153,7 @@ json get_core_shapes() {
 
 json get_core_shape_families() {
     try {
-        auto shapes = OpenMagnetics::get_shapes(false);
-        std::vector<CoreShapeFamily> families;
-        json result = json::array();
-        for (auto elem : shapes) {
-            auto family = elem.get_family();
-            if (std::find(families.begin(), families.end(), family) == families.end()) {
-                families.push_back(family);
-                json aux;
-                to_json(aux, family);
-                result.push_back(aux);
-            }
-        }
-        return result;
+        return get_catalog_names()->shapeFamilies;
     }
     catch (const std::exception &exc) {
         json exception;
@@ -99,6 +164,7 @@ json get_core_shape_families() {
 
 json get_core_material_names() {
     try {
+        materialize_all_records();
         auto materialNames = OpenMagnetics::get_core_material_names(std::nullopt);
         json result = json::array();
         for (auto elem : materialNames) {
@@ -115,6 +181,7 @@ json get_core_material_names() {
 
 json get_core_material_names_by_manufacturer(std::string manufacturerName) {
     try {
+        materialize_all_records();
         auto materialNames = OpenMagnetics::get_core_material_names(manufacturerName);
         json result = json::array();
         for (auto elem : materialNames) {
@@ -131,6 +198,7 @@ json get_core_material_names_by_manufacturer(std::string manufacturerName) {
 
 json get_core_shape_names(bool includeToroidal) {
     try {
+        materialize_all_records();
         OpenMagnetics::settings->set_use_toroidal_cores(includeToroidal);
         auto shapeNames = OpenMagnetics::get_core_shape_names();
         json result = json::array();
@@ -148,6 +216,7 @@ json get_core_shape_names(bool includeToroidal) {
 
 json find_core_material_by_name(json materialName) {
     try {
+        materialize_references(materialName);
         auto materialData = OpenMagnetics::find_core_material_by_name(materialName);
         json result;
         to_json(result, materialData);
@@ -162,6 +231,7 @@ json find_core_material_by_name(json materialName) {
 
 json find_core_shape_by_name(json shapeName) {
     try {
+        materialize_references(shapeName);
         auto shapeData = OpenMagnetics::find_core_shape_by_name(shapeName);
         json result;
         to_json(result, shapeData);
@@ -176,8 +246,9 @@ json find_core_shape_by_name(json shapeName) {
 
 json calculate_core_processed_description(json coreDataJson) {
     try {
+        materialize_references(coreDataJson);
         OpenMagnetics::Core core(coreDataJson, false, false, false);
-        core.process_data();
+        process_core(core);
         json result;
         to_json(result, core.get_processed_description().value());
         return result;
@@ -191,6 +262,7 @@ json calculate_core_processed_description(json coreDataJson) {
 
 json calculate_core_geometrical_description(json coreDataJson) {
     try {
+        materialize_references(coreDataJson);
         OpenMagnetics::Core core(coreDataJson, false, false, false);
         auto geometricalDescription = core.create_geometrical_description().value();
         json result = json::array();
@@ -210,8 +282,9 @@ json calculate_core_geometrical_description(json coreDataJson) {
 
 json calculate_core_gapping(json coreDataJson) {
     try {
+        materialize_references(coreDataJson);
         OpenMagnetics::Core core(coreDataJson, false, false, false);
-        core.process_gap();
+        process_core(core);
         json result = json::array();
         for (auto& gap : core.get_functional_description().get_gapping()) {
             json aux;
@@ -255,7 +328,9 @@ json calculate_shape_data(json shapeJson) {
 
 json calculate_core_data(json coreDataJson, bool includeMaterialData) {
     try {
-        OpenMagnetics::Core core(coreDataJson, includeMaterialData, true);
+        materialize_references(coreDataJson);
+        OpenMagnetics::Core core(coreDataJson, includeMaterialData, false, false);
+        process_core(core);
         json result;
         to_json(result, core);
         return result;
@@ -266,17 +341,67 @@ json calculate_core_data(json coreDataJson, bool includeMaterialData) {
 }
 
 json load_core_data(json coresJson) {
-    json result = json::array();
-    for (auto& coreJson : coresJson) {
-        OpenMagnetics::Core core(coreJson, false);
-        json aux;
-        to_json(aux, core);
-        result.push_back(aux);
-    }
+    materialize_references(coresJson);
+    ensure_core_databases_loaded();
+    const json& cores = coresJson;
+    std::vector<json> result(cores.size());
+    py::gil_scoped_release release;
+    parallel_for(cores.size(), [&](size_t coreIndex) {
+        OpenMagnetics::Core core(cores[coreIndex], false, false, false);
+        process_core(core);
+        to_json(result[coreIndex], core);
+    });
     return result;
 }
 
+// Cores are processed on the worker threads and returned in input order. Each item is the result,
+// or the error that stopped it, so one bad core does not abort the batch.
+json calculate_core_data_batch(std::vector<json> coresJson, bool includeMaterialData, std::string output) {
+    try {
+        if (output != "core" && output != "processedDescription" && output != "geometricalDescription") {
+            throw std::invalid_argument("Unknown output " + output + ", expected core, processedDescription or geometricalDescription");
+        }
+        for (auto& coreJson : coresJson) {
+            materialize_references(coreJson);
+        }
+        ensure_core_databases_loaded();
+        std::vector<json> result(coresJson.size());
+        py::gil_scoped_release release;
+        parallel_for(coresJson.size(), [&](size_t coreIndex) {
+            try {
+                if (output == "core") {
+                    OpenMagnetics::Core core(coresJson[coreIndex], includeMaterialData, false, false);
+                    process_core(core);
+                    to_json(result[coreIndex], core);
+                }
+                else if (output == "processedDescription") {
+                    OpenMagnetics::Core core(coresJson[coreIndex], false, false, false);
+                    process_core(core);
+                    to_json(result[coreIndex], core.get_processed_description().value());
+                }
+                else {
+                    OpenMagnetics::Core core(coresJson[coreIndex], false, false, false);
+                    result[coreIndex] = json::array();
+                    for (auto& elem : core.create_geometrical_description().value()) {
+                        json aux;
+                        to_json(aux, elem);
+                        result[coreIndex].push_back(aux);
+                    }
+                }
+            }
+            catch (const std::exception &exc) {
+                result[coreIndex] = "Exception: " + std::string{exc.what()};
+            }
+        });
+        return result;
+    }
+    catch (const std::exception &exc) {
+        return "Exception: " + std::string{exc.what()};
+    }
+}
+
 json get_material_data(std::string materialName) {
+    materialize_record(materialName);
     auto materialData = OpenMagnetics::find_core_material_by_name(materialName);
     json result;
     to_json(result, materialData);
@@ -284,6 +409,7 @@ json get_material_data(std::string materialName) {
 }
 
 json get_core_temperature_dependant_parameters(json coreData, double temperature) {
+    materialize_references(coreData);
     OpenMagnetics::Core core(coreData);
     json result;
 
@@ -299,8 +425,70 @@ json get_core_temperature_dependant_parameters(json coreData, double temperature
     return result;
 }
 
+// The core and its ungapped reluctance are computed once, then every quantity is evaluated per
+// temperature. Values the models cannot give at some temperature are NaN.
+py::dict get_core_temperature_dependant_parameters_sweep(json coreData, py::array_t<double, py::array::c_style | py::array::forcecast> temperatures, bool releaseGil) {
+    std::vector<double> temperatureValues(temperatures.data(), temperatures.data() + temperatures.size());
+    size_t size = temperatureValues.size();
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> magneticFluxDensitySaturation(size, nan);
+    std::vector<double> magneticFieldStrengthSaturation(size, nan);
+    std::vector<double> initialPermeability(size, nan);
+    std::vector<double> effectivePermeability(size, nan);
+    std::vector<double> reluctance(size, nan);
+    std::vector<double> resistivity(size, nan);
+    double permeance = nan;
+    try {
+        materialize_references(coreData);
+        ensure_core_databases_loaded();
+        std::optional<py::gil_scoped_release> release;
+        if (releaseGil) {
+            release.emplace();
+        }
+        OpenMagnetics::Core core(coreData, false, false, false);
+        process_core(core);
+        auto reluctanceModel = OpenMagnetics::ReluctanceModel::factory();
+        permeance = 1.0 / reluctanceModel->get_ungapped_core_reluctance(core);
+
+        auto evaluate = [](std::vector<double>& column, size_t index, const std::function<double()>& quantity) {
+            try {
+                column[index] = quantity();
+            }
+            catch (const std::exception &) {
+            }
+        };
+        for (size_t index = 0; index < size; ++index) {
+            double temperature = temperatureValues[index];
+            evaluate(magneticFluxDensitySaturation, index, [&] { return core.get_magnetic_flux_density_saturation(temperature, false); });
+            evaluate(magneticFieldStrengthSaturation, index, [&] { return core.get_magnetic_field_strength_saturation(temperature); });
+            evaluate(initialPermeability, index, [&] { return core.get_initial_permeability(temperature); });
+            evaluate(effectivePermeability, index, [&] { return core.get_effective_permeability(temperature); });
+            evaluate(reluctance, index, [&] { return core.get_reluctance(temperature); });
+            evaluate(resistivity, index, [&] { return core.get_resistivity(temperature); });
+        }
+    }
+    catch (const std::exception &exc) {
+        throw std::runtime_error("Exception: " + std::string{exc.what()});
+    }
+
+    auto to_array = [](const std::vector<double>& column) {
+        return py::array_t<double>(static_cast<py::ssize_t>(column.size()), column.data());
+    };
+    py::dict result;
+    result["temperature"] = to_array(temperatureValues);
+    result["magneticFluxDensitySaturation"] = to_array(magneticFluxDensitySaturation);
+    result["magneticFieldStrengthSaturation"] = to_array(magneticFieldStrengthSaturation);
+    result["initialPermeability"] = to_array(initialPermeability);
+    result["effectivePermeability"] = to_array(effectivePermeability);
+    result["reluctance"] = to_array(reluctance);
+    result["permeance"] = to_array(std::vector<double>(size, permeance));
+    result["resistivity"] = to_array(resistivity);
+    return result;
+}
+
 json get_shape_data(std::string shapeName) {
     try {
+        materialize_record(shapeName);
         auto shapeData = OpenMagnetics::find_core_shape_by_name(shapeName);
         json result;
         to_json(result, shapeData);
@@ -321,15 +509,7 @@ std::vector<std::string> get_available_shape_families() {
 }
 
 std::vector<std::string> get_available_core_manufacturers() {
-    std::vector<std::string> manufacturers;
-    auto materials = OpenMagnetics::get_materials("");
-    for (auto material : materials) {
-        std::string manufacturer = material.get_manufacturer_info().get_name();
-        if (std::find(manufacturers.begin(), manufacturers.end(), manufacturer) == manufacturers.end()) {
-            manufacturers.push_back(manufacturer);
-        }
-    }
-    return manufacturers;
+    return get_catalog_names()->manufacturers;
 }
 
 std::vector<std::string> get_available_core_shape_families() {
@@ -342,15 +522,18 @@ std::vector<std::string> get_available_core_shape_families() {
 }
 
 std::vector<std::string> get_available_core_materials(std::string manufacturer) {
+    materialize_all_records();
     return OpenMagnetics::get_core_material_names(manufacturer);
 }
 
 std::vector<std::string> get_available_core_shapes() {
+    materialize_all_records();
     return OpenMagnetics::get_core_shape_names();
 }
 
 json get_available_cores() {
-    if (OpenMagnetics::coreMaterialDatabase.empty()) {
+    materialize_all_records();
+    if (OpenMagnetics::coreDatabase.empty()) {
         OpenMagnetics::load_cores();
     }
 
@@ -382,6 +565,76 @@ json calculate_gap_reluctance(json coreGapData, std::string modelNameString) {
     return result;
 }
 
+// Gaps are split in chunks, each task builds its own model instance and reuses it for its chunk
+py::dict calculate_gap_reluctance_batch(std::vector<json> coreGapsData, std::vector<std::string> modelNames) {
+    constexpr size_t gapsPerTask = 256;
+    std::vector<OpenMagnetics::ReluctanceModels> models;
+    std::vector<double> reluctances;
+    std::vector<double> fringingFactors;
+    try {
+        py::gil_scoped_release release;
+        for (auto modelName : modelNames) {
+            std::transform(modelName.begin(), modelName.end(), modelName.begin(), ::toupper);
+            auto model = magic_enum::enum_cast<OpenMagnetics::ReluctanceModels>(modelName);
+            if (!model) {
+                throw std::invalid_argument("Unknown reluctance model " + modelName);
+            }
+            models.push_back(model.value());
+        }
+        if (models.empty()) {
+            for (auto model : magic_enum::enum_values<OpenMagnetics::ReluctanceModels>()) {
+                models.push_back(model);
+            }
+        }
+
+        std::vector<std::optional<CoreGap>> coreGaps(coreGapsData.size());
+        parallel_for(coreGapsData.size(), [&](size_t gapIndex) {
+            try {
+                coreGaps[gapIndex] = CoreGap(coreGapsData[gapIndex]);
+            }
+            catch (const std::exception &) {
+            }
+        });
+
+        // Gaps that cannot be parsed or evaluated stay NaN
+        reluctances.assign(models.size() * coreGaps.size(), std::numeric_limits<double>::quiet_NaN());
+        fringingFactors.assign(models.size() * coreGaps.size(), std::numeric_limits<double>::quiet_NaN());
+        size_t chunksPerModel = (coreGaps.size() + gapsPerTask - 1) / gapsPerTask;
+        parallel_for(models.size() * chunksPerModel, [&](size_t taskIndex) {
+            size_t modelIndex = taskIndex / chunksPerModel;
+            size_t firstGap = (taskIndex % chunksPerModel) * gapsPerTask;
+            size_t lastGap = std::min(firstGap + gapsPerTask, coreGaps.size());
+            auto reluctanceModel = OpenMagnetics::ReluctanceModel::factory(models[modelIndex]);
+            for (size_t gapIndex = firstGap; gapIndex < lastGap; ++gapIndex) {
+                if (!coreGaps[gapIndex]) {
+                    continue;
+                }
+                try {
+                    auto coreGapResult = reluctanceModel->get_gap_reluctance(coreGaps[gapIndex].value());
+                    reluctances[modelIndex * coreGaps.size() + gapIndex] = coreGapResult.get_reluctance();
+                    fringingFactors[modelIndex * coreGaps.size() + gapIndex] = coreGapResult.get_fringing_factor();
+                }
+                catch (const std::exception &) {
+                }
+            }
+        });
+    }
+    catch (const std::exception &exc) {
+        throw std::runtime_error("Exception: " + std::string{exc.what()});
+    }
+
+    std::vector<py::ssize_t> shape{static_cast<py::ssize_t>(models.size()), static_cast<py::ssize_t>(coreGapsData.size())};
+    std::vector<std::string> names;
+    for (auto model : models) {
+        names.push_back(std::string(magic_enum::enum_name(model)));
+    }
+    py::dict result;
+    result["reluctance"] = py::array_t<double>(shape, reluctances.data());
+    result["fringingFactor"] = py::array_t<double>(shape, fringingFactors.data());
+    result["models"] = names;
+    return result;
+}
+
 json get_gap_reluctance_model_information() {
     json info;
     info["information"] = OpenMagnetics::ReluctanceModel::get_models_information();
@@ -392,6 +645,7 @@ json get_gap_reluctance_model_information() {
 }
 
 double calculate_inductance_from_number_turns_and_gapping(json coreData, json coilData, json operatingPointData, json modelsData) {
+    materialize_references(coreData, coilData, operatingPointData, modelsData);
     OpenMagnetics::Core core(coreData);
     OpenMagnetics::Coil coil(coilData);
     OperatingPoint operatingPoint(operatingPointData);
@@ -412,6 +666,7 @@ double calculate_inductance_from_number_turns_and_gapping(json coreData, json co
 }
 
 double calculate_number_turns_from_gapping_and_inductance(json coreData, json inputsData, json modelsData) {
+    materialize_references(coreData, inputsData, modelsData);
     OpenMagnetics::Core core(coreData);
     OpenMagnetics::Inputs inputs(inputsData);
 
@@ -429,7 +684,9 @@ double calculate_number_turns_from_gapping_and_inductance(json coreData, json in
 }
 
 json calculate_gapping_from_number_turns_and_inductance(json coreData, json coilData, json inputsData, std::string gappingTypeJson, int decimals, json modelsData) {
-    OpenMagnetics::Core core(coreData);
+    materialize_references(coreData, coilData, inputsData, modelsData);
+    OpenMagnetics::Core core(coreData, false, false, false);
+    process_core(core);
     OpenMagnetics::Coil coil(coilData);
     OpenMagnetics::Inputs inputs(inputsData);
 
@@ -448,24 +705,105 @@ json calculate_gapping_from_number_turns_and_inductance(json coreData, json coil
     core.set_processed_description(std::nullopt);
     core.set_geometrical_description(std::nullopt);
     core.get_mutable_functional_description().set_gapping(gapping);
-    core.process_data();
-    core.process_gap();
-    auto geometricalDescription = core.create_geometrical_description();
-    core.set_geometrical_description(geometricalDescription);
+    process_core(core);
 
     json result;
     to_json(result, core);
     return result;
 }
 
+// Cores are processed once per gap length, then each (model, gap length) pair is a task that
+// walks every number of turns on its own copies of the core and coil
+py::dict calculate_inductance_sweep(json coreData, json coilData, json operatingPointData, std::vector<int64_t> numbersTurns, std::vector<double> gapLengths, std::vector<std::string> reluctanceModelNames) {
+    std::vector<OpenMagnetics::ReluctanceModels> reluctanceModels;
+    std::vector<double> magnetizingInductances;
+    std::vector<double> magneticFluxDensityPeaks;
+    try {
+        materialize_references(coreData, coilData, operatingPointData);
+        ensure_databases_loaded();
+        py::gil_scoped_release release;
+        for (auto modelName : reluctanceModelNames) {
+            std::transform(modelName.begin(), modelName.end(), modelName.begin(), ::toupper);
+            auto reluctanceModel = magic_enum::enum_cast<OpenMagnetics::ReluctanceModels>(modelName);
+            if (!reluctanceModel) {
+                throw std::invalid_argument("Unknown reluctance model " + modelName);
+            }
+            reluctanceModels.push_back(reluctanceModel.value());
+        }
+        if (reluctanceModels.empty()) {
+            reluctanceModels.push_back(OpenMagnetics::defaults.reluctanceModelDefault);
+        }
+
+        OpenMagnetics::Core unprocessedCore(coreData, false, false, false);
+        auto gapping = unprocessedCore.get_functional_description().get_gapping();
+        if (std::none_of(gapping.begin(), gapping.end(), [](const CoreGap& gap) { return gap.get_type() != GapType::RESIDUAL; })) {
+            throw std::invalid_argument("Core has no subtractive or additive gap to sweep");
+        }
+        std::vector<OpenMagnetics::Core> cores(gapLengths.size(), unprocessedCore);
+        parallel_for(gapLengths.size(), [&](size_t gapIndex) {
+            auto sweptGapping = gapping;
+            for (auto& gap : sweptGapping) {
+                if (gap.get_type() != GapType::RESIDUAL) {
+                    gap.set_length(gapLengths[gapIndex]);
+                }
+            }
+            cores[gapIndex].get_mutable_functional_description().set_gapping(sweptGapping);
+            process_core(cores[gapIndex]);
+        });
+
+        OpenMagnetics::Coil coil(coilData);
+        OperatingPoint operatingPoint(operatingPointData);
+        size_t numberCells = reluctanceModels.size() * numbersTurns.size() * gapLengths.size();
+        // Points the models cannot evaluate stay NaN
+        magnetizingInductances.assign(numberCells, std::numeric_limits<double>::quiet_NaN());
+        magneticFluxDensityPeaks.assign(numberCells, std::numeric_limits<double>::quiet_NaN());
+        parallel_for(reluctanceModels.size() * gapLengths.size(), [&](size_t taskIndex) {
+            size_t modelIndex = taskIndex / gapLengths.size();
+            size_t gapIndex = taskIndex % gapLengths.size();
+            auto core = cores[gapIndex];
+            auto sweptCoil = coil;
+            OpenMagnetics::MagnetizingInductance magnetizingInductanceObj(reluctanceModels[modelIndex]);
+            for (size_t turnsIndex = 0; turnsIndex < numbersTurns.size(); ++turnsIndex) {
+                size_t cellIndex = (modelIndex * numbersTurns.size() + turnsIndex) * gapLengths.size() + gapIndex;
+                try {
+                    sweptCoil.get_mutable_functional_description()[0].set_number_turns(numbersTurns[turnsIndex]);
+                    auto sweptOperatingPoint = operatingPoint;
+                    auto [magnetizingInductanceOutput, magneticFluxDensity] = magnetizingInductanceObj.calculate_inductance_and_magnetic_flux_density(core, sweptCoil, &sweptOperatingPoint);
+                    magnetizingInductances[cellIndex] = magnetizingInductanceOutput.get_magnetizing_inductance().get_nominal().value();
+                    magneticFluxDensityPeaks[cellIndex] = magneticFluxDensity.get_processed().value().get_peak().value();
+                }
+                catch (const std::exception &) {
+                }
+            }
+        });
+    }
+    catch (const std::exception &exc) {
+        throw std::runtime_error("Exception: " + std::string{exc.what()});
+    }
+
+    std::vector<py::ssize_t> shape;
+    if (!reluctanceModelNames.empty()) {
+        shape.push_back(static_cast<py::ssize_t>(reluctanceModels.size()));
+    }
+    shape.push_back(static_cast<py::ssize_t>(numbersTurns.size()));
+    shape.push_back(static_cast<py::ssize_t>(gapLengths.size()));
+    py::array_t<double> magnetizingInductance(shape, magnetizingInductances.data());
+    py::array_t<double> magneticFluxDensityPeak(shape, magneticFluxDensityPeaks.data());
+    py::dict result;
+    result["magnetizingInductance"] = magnetizingInductance;
+    result["magneticFluxDensityPeak"] = magneticFluxDensityPeak;
+    result["numberTurns"] = numbersTurns;
+    result["gapLength"] = gapLengths;
+    result["reluctanceModels"] = reluctanceModelNames;
+    return result;
+}
+
 double calculate_core_maximum_magnetic_energy(json coreDataJson, json operatingPointJson) {
     try {
+        materialize_references(coreDataJson, operatingPointJson);
         OperatingPoint operatingPoint = OperatingPoint(operatingPointJson);
         OpenMagnetics::Core core = OpenMagnetics::Core(coreDataJson, false, false, false);
-        if (!core.get_processed_description()) {
-            core.process_data();
-            core.process_gap();
-        }
+        process_core(core);
 
         auto magneticEnergy = OpenMagnetics::MagneticEnergy();
 
@@ -485,27 +823,223 @@ double calculate_core_maximum_magnetic_energy(json coreDataJson, json operatingP
 }
 
 double calculate_saturation_current(json magneticJson, double temperature) {
+    materialize_references(magneticJson);
     OpenMagnetics::Magnetic magnetic(magneticJson);
     return magnetic.calculate_saturation_current(temperature);
 }
 
 double calculate_temperature_from_core_thermal_resistance(json coreJson, double totalLosses) {
+    materialize_references(coreJson);
     OpenMagnetics::Core core(coreJson);
     return OpenMagnetics::Temperature::calculate_temperature_from_core_thermal_resistance(core, totalLosses);
 }
 
+namespace {
+
+// Read-only view on a catalog column, the capsule keeps the catalog alive while NumPy holds it
+template<typename T>
+py::array_t<T> make_catalog_column(const std::shared_ptr<const CoreCatalog>& catalog, const std::vector<T>& column) {
+    auto owner = new std::shared_ptr<const CoreCatalog>(catalog);
+    py::capsule capsule(owner, [](void* pointer) {
+        delete static_cast<std::shared_ptr<const CoreCatalog>*>(pointer);
+    });
+    py::array_t<T> array(column.size(), column.data(), capsule);
+    array.attr("setflags")(py::arg("write") = false);
+    return array;
+}
+
+} // namespace
+
+py::dict get_core_catalog_table() {
+    std::shared_ptr<const CoreCatalog> catalog;
+    try {
+        // Built with the GIL held: it materializes and loads cores into the OpenMagnetics databases,
+        // which other Python threads read under the GIL
+        catalog = get_core_catalog();
+    }
+    catch (const std::exception &exc) {
+        throw std::runtime_error("Exception: " + std::string{exc.what()});
+    }
+
+    py::dict table;
+    table["reference"] = catalog->references;
+    table["effectiveArea"] = make_catalog_column(catalog, catalog->effectiveArea);
+    table["effectiveLength"] = make_catalog_column(catalog, catalog->effectiveLength);
+    table["effectiveVolume"] = make_catalog_column(catalog, catalog->effectiveVolume);
+    table["windingWindowArea"] = make_catalog_column(catalog, catalog->windingWindowArea);
+    table["columnArea"] = make_catalog_column(catalog, catalog->columnArea);
+    table["areaProduct"] = make_catalog_column(catalog, catalog->areaProduct);
+    table["height"] = make_catalog_column(catalog, catalog->height);
+    table["estimatedMass"] = make_catalog_column(catalog, catalog->estimatedMass);
+    table["numberStacks"] = make_catalog_column(catalog, catalog->numberStacks);
+    table["materialId"] = make_catalog_column(catalog, catalog->materialIds);
+    table["shapeId"] = make_catalog_column(catalog, catalog->shapeIds);
+    table["familyId"] = make_catalog_column(catalog, catalog->familyIds);
+    table["manufacturerId"] = make_catalog_column(catalog, catalog->manufacturerIds);
+    table["materialNames"] = catalog->materialNames;
+    table["shapeNames"] = catalog->shapeNames;
+    table["familyNames"] = catalog->familyNames;
+    table["manufacturerNames"] = catalog->manufacturerNames;
+    return table;
+}
+
+namespace {
+
+const std::map<std::string, CoreCatalogKey> coreCatalogKeys = {
+    {"areaProduct", CoreCatalogKey::AREA_PRODUCT},
+    {"effectiveArea", CoreCatalogKey::EFFECTIVE_AREA},
+    {"effectiveVolume", CoreCatalogKey::EFFECTIVE_VOLUME},
+    {"windingWindowArea", CoreCatalogKey::WINDING_WINDOW_AREA},
+    {"height", CoreCatalogKey::HEIGHT},
+};
+
+std::vector<std::string> get_filter_names(const json& filters, const std::string& name) {
+    if (!filters.contains(name)) {
+        return {};
+    }
+    if (filters[name].is_string()) {
+        return {filters[name].get<std::string>()};
+    }
+    return filters[name].get<std::vector<std::string>>();
+}
+
+json get_catalog_field(const CoreCatalog& catalog, size_t row, const std::string& field) {
+    if (field == "effectiveArea") return catalog.effectiveArea[row];
+    if (field == "effectiveLength") return catalog.effectiveLength[row];
+    if (field == "effectiveVolume") return catalog.effectiveVolume[row];
+    if (field == "windingWindowArea") return catalog.windingWindowArea[row];
+    if (field == "columnArea") return catalog.columnArea[row];
+    if (field == "areaProduct") return catalog.areaProduct[row];
+    if (field == "height") return catalog.height[row];
+    if (field == "estimatedMass") return catalog.estimatedMass[row];
+    if (field == "numberStacks") return catalog.numberStacks[row];
+    if (field == "material") return catalog.materialNames[catalog.materialIds[row]];
+    if (field == "shape") return catalog.shapeNames[catalog.shapeIds[row]];
+    if (field == "family") return catalog.familyNames[catalog.familyIds[row]];
+    if (field == "manufacturer") return catalog.manufacturerNames[catalog.manufacturerIds[row]];
+    throw std::invalid_argument("Unknown core catalog field: " + field);
+}
+
+} // namespace
+
+json query_cores(json rangesJson, json filtersJson, std::vector<std::string> fields) {
+    try {
+        std::vector<CoreCatalogRange> ranges;
+        for (auto& [name, limits] : rangesJson.items()) {
+            auto key = coreCatalogKeys.find(name);
+            if (key == coreCatalogKeys.end()) {
+                throw std::invalid_argument("Unknown core catalog range: " + name);
+            }
+            if (!limits.is_array() || limits.size() != 2) {
+                throw std::invalid_argument("Range " + name + " must be [minimum, maximum]");
+            }
+            // null leaves that end of the range open
+            double minimum = limits[0].is_null() ? -std::numeric_limits<double>::infinity() : limits[0].get<double>();
+            double maximum = limits[1].is_null() ? std::numeric_limits<double>::infinity() : limits[1].get<double>();
+            ranges.push_back({key->second, minimum, maximum});
+        }
+        CoreCatalogFilter filter;
+        if (!filtersJson.is_null()) {
+            filter.materials = get_filter_names(filtersJson, "material");
+            filter.families = get_filter_names(filtersJson, "family");
+            filter.manufacturers = get_filter_names(filtersJson, "manufacturer");
+        }
+
+        auto catalog = get_core_catalog();
+        json result = json::array();
+        for (auto row : catalog->query(ranges, filter)) {
+            if (fields.empty()) {
+                result.push_back(catalog->references[row]);
+                continue;
+            }
+            json core;
+            core["reference"] = catalog->references[row];
+            for (auto& field : fields) {
+                core[field] = get_catalog_field(*catalog, row, field);
+            }
+            result.push_back(core);
+        }
+        return result;
+    }
+    catch (const std::exception &exc) {
+        json exception;
+        exception["data"] = "Exception: " + std::string{exc.what()};
+        return exception;
+    }
+}
+
+py::dict get_core_energy_map_table(std::vector<double> temperatures) {
+    std::shared_ptr<const CoreEnergyMap> map;
+    try {
+        load_core_energy_map_databases();
+        py::gil_scoped_release release;
+        map = get_core_energy_map(temperatures);
+    }
+    catch (const std::exception &exc) {
+        throw std::runtime_error("Exception: " + std::string{exc.what()});
+    }
+
+    auto to_matrix = [&](const std::vector<std::vector<double>>& rows) {
+        py::array_t<double> matrix(std::vector<py::ssize_t>{static_cast<py::ssize_t>(map->temperatures.size()), static_cast<py::ssize_t>(map->size())});
+        auto data = matrix.mutable_data();
+        for (auto& row : rows) {
+            data = std::copy(row.begin(), row.end(), data);
+        }
+        return matrix;
+    };
+    py::dict table;
+    table["reference"] = map->references;
+    table["temperature"] = py::array_t<double>(static_cast<py::ssize_t>(map->temperatures.size()), map->temperatures.data());
+    table["maximumMagneticEnergy"] = to_matrix(map->maximumMagneticEnergy);
+    table["saturationAmpereTurns"] = to_matrix(map->saturationAmpereTurns);
+    return table;
+}
+
+json query_cores_by_energy(double requiredEnergy, double temperature, size_t maximumResults) {
+    try {
+        load_core_energy_map_databases();
+        py::gil_scoped_release release;
+        auto map = get_core_energy_map({});
+        auto temperatureIndex = map->get_temperature_index(temperature);
+        json result = json::array();
+        for (auto row : map->query(requiredEnergy, temperatureIndex, maximumResults)) {
+            json core;
+            core["reference"] = map->references[row];
+            core["temperature"] = map->temperatures[temperatureIndex];
+            core["maximumMagneticEnergy"] = map->maximumMagneticEnergy[temperatureIndex][row];
+            core["saturationAmpereTurns"] = map->saturationAmpereTurns[temperatureIndex][row];
+            result.push_back(core);
+        }
+        return result;
+    }
+    catch (const std::exception &exc) {
+        json exception;
+        exception["data"] = "Exception: " + std::string{exc.what()};
+        return exception;
+    }
+}
+
 void register_core_bindings(py::module& m) {
     // Core materials
     m.def("get_core_materials", &get_core_materials, "Retrieve all available core materials as JSON objects");
     m.def("get_material_permeability", &get_material_permeability, 
         "Calculate initial permeability for a material at given temperature, DC bias, and frequency",
         py::arg("material_name"), py::arg("temperature"), py::arg("magnetic_field_dc_bias"), py::arg("frequency"));
+    m.def("get_material_permeability_batch", &get_material_permeability_batch,
+        "Calculate initial permeability over NumPy arrays of temperatures, DC biases and frequencies, broadcast together",
+        py::arg("material_name"), py::arg("temperatures"), py::arg("magnetic_field_dc_biases"), py::arg("frequencies"));
     m.def("get_material_resistivity", &get_material_resistivity,
         "Calculate resistivity for a material at given temperature",
         py::arg("material_name"), py::arg("temperature"));
     m.def("get_core_material_steinmetz_coefficients", &get_core_material_steinmetz_coefficients,
         "Retrieve Steinmetz coefficients for core loss calculation at given frequency",
         py::arg("material_name"), py::arg("frequency"));
+    m.def("set_material_surface_cache", &set_material_surface_cache,
+        "Answer permeability and resistivity queries by interpolating on a per-material grid of temperature, DC bias and frequency",
+        py::arg("enabled"), py::arg("grid") = json::object());
+    m.def("clear_material_surface_cache", &clear_material_surface_cache, "Drop every material surface built so far");
+    m.def("get_material_surface_cache_statistics", &get_material_surface_cache_statistics,
+        "Grid, hits, misses and, per material, build time and maximum interpolation error of the material surface cache");
 
     // Core shapes
     m.def("get_core_shapes", &get_core_shapes, "Retrieve all available core shapes as JSON objects");
@@ -529,9 +1063,21 @@ void register_core_bindings(py::module& m) {
     m.def("calculate_core_processed_description", &calculate_core_processed_description, "Calculate processed description for a core");
     m.def("calculate_core_geometrical_description", &calculate_core_geometrical_description, "Calculate geometrical description for a core");
     m.def("calculate_core_gapping", &calculate_core_gapping, "Calculate gapping configuration for a core");
+    m.def("set_core_processing_cache_size", &set_core_processing_cache_size,
+        "Keep up to maximum_entries processed cores in memory, keyed by functional description. 0 disables the cache",
+        py::arg("maximum_entries"));
+    m.def("clear_core_processing_cache", &clear_core_processing_cache, "Drop every processed core kept in memory");
+    m.def("get_core_processing_cache_statistics", &get_core_processing_cache_statistics,
+        "Entries, capacity, hits, misses, evictions and hit rate of the core processing cache");
     m.def("load_core_data", &load_core_data, "Load core data from JSON");
+    m.def("calculate_core_data_batch", &calculate_core_data_batch,
+        "Process cores in parallel, returning for each the complete core, its processed description or its geometrical description, or the error message",
+        py::arg("cores"), py::arg("include_material_data") = false, py::arg("output") = "core");
     m.def("get_material_data", &get_material_data, "Get material data by name");
     m.def("get_core_temperature_dependant_parameters", &get_core_temperature_dependant_parameters, "Get temperature-dependent core parameters");
+    m.def("get_core_temperature_dependant_parameters_sweep", &get_core_temperature_dependant_parameters_sweep,
+        "Temperature-dependent core parameters over an array of temperatures, as a NumPy column per parameter",
+        py::arg("core"), py::arg("temperatures"), py::arg("release_gil") = true);
     m.def("calculate_shape_data", &calculate_shape_data, "Calculate shape parameters");
     m.def("get_shape_data", &get_shape_data, "Get shape data by name");
 
@@ -539,17 +1085,44 @@ void register_core_bindings(py::module& m) {
     m.def("get_available_shape_families", &get_available_shape_families, "Get list of available shape families");
     m.def("get_available_core_materials", &get_available_core_materials, "Get list of available core materials");
     m.def("get_available_core_manufacturers", &get_available_core_manufacturers, "Get list of core manufacturers");
+    m.def("get_catalog_facets", &get_catalog_facets, "Get manufacturers, shape families, materials and shapes of the catalog with their counts");
     m.def("get_available_core_shape_families", &get_available_core_shape_families, "Get list of available core shape families");
     m.def("get_available_core_shapes", &get_available_core_shapes, "Get list of available core shapes");
     m.def("get_available_cores", &get_available_cores, "Get list of all available cores");
+    m.def("get_core_catalog_table", &get_core_catalog_table,
+        "Get the core database as read-only NumPy columns, one row per core in get_available_cores order. estimatedMass is material density times effective volume, which only approximates the physical mass as Ve follows the magnetic path");
+    m.def("query_cores", &query_cores,
+        "Get the references of the cores inside every [minimum, maximum] range that match the material, family and manufacturer filters, optionally with the given fields",
+        py::arg("ranges"), py::arg("filters") = json::object(), py::arg("fields") = std::vector<std::string>{});
+    m.def("get_core_energy_map_table", &get_core_energy_map_table,
+        "Maximum magnetic energy and saturation ampere-turns of every catalog core at each temperature, as temperatures by cores NumPy arrays. Empty temperatures reuse the last ones",
+        py::arg("temperatures") = std::vector<double>{});
+    m.def("query_cores_by_energy", &query_cores_by_energy,
+        "Catalog cores able to store at least required_energy at the first precomputed temperature not below temperature, by increasing energy",
+        py::arg("required_energy"), py::arg("temperature") = 100.0, py::arg("maximum_results") = 0);
 
     // Gap and reluctance
     m.def("calculate_gap_reluctance", &calculate_gap_reluctance, "Calculate magnetic reluctance of an air gap");
+    m.def("calculate_gap_reluctance_batch", &calculate_gap_reluctance_batch,
+        "Reluctance and fringing factor of many gaps under the given reluctance models, or all of them, as NumPy arrays shaped models by gaps",
+        py::arg("gaps"), py::arg("models") = std::vector<std::string>{});
     m.def("get_gap_reluctance_model_information", &get_gap_reluctance_model_information, "Get information about gap reluctance models");
     m.def("calculate_inductance_from_number_turns_and_gapping", &calculate_inductance_from_number_turns_and_gapping,
         "Calculate inductance from turns count and gap configuration");
     m.def("calculate_number_turns_from_gapping_and_inductance", &calculate_number_turns_from_gapping_and_inductance,
         "Calculate required number of turns from gap and target inductance");
+    m.def("solve_gapping_from_number_turns_and_inductance", &solve_gapping_from_number_turns_and_inductance,
+        "Solve the length of the non-residual gaps for the required magnetizing inductance with a bracketed Brent search, reporting iterations and residual",
+        py::arg("core"), py::arg("coil"), py::arg("inputs"), py::arg("models") = json::object(), py::arg("tolerance") = 1e-6,
+        py::arg("maximum_iterations") = 100, py::arg("include_core") = false);
+    m.def("solve_number_turns_from_gapping_and_inductance", &solve_number_turns_from_gapping_and_inductance,
+        "Solve the number of turns of the first winding for the required magnetizing inductance with Newton steps, reporting iterations, residual, whether the iteration settled and whether the residual is within tolerance",
+        py::arg("core"), py::arg("coil"), py::arg("inputs"), py::arg("models") = json::object(), py::arg("tolerance") = 1e-6,
+        py::arg("maximum_iterations") = 20);
+    m.def("calculate_inductance_sweep", &calculate_inductance_sweep,
+        "Magnetizing inductance and peak flux density over numbers of turns of the first winding by lengths of the non-residual gaps, and by reluctance models when given, as NumPy arrays",
+        py::arg("core"), py::arg("coil"), py::arg("operating_point"), py::arg("numbers_turns"), py::arg("gap_lengths"),
+        py::arg("reluctance_models") = std::vector<std::string>{});
     m.def("calculate_gapping_from_number_turns_and_inductance", &calculate_gapping_from_number_turns_and_inductance,
         "Calculate required gap from turns count and target inductance");
 
@@ -1,12 +1,14 @@
 #pragma once
 
 #include "common.h"
+#include <pybind11/numpy.h>
 
 namespace PyMKF {
 
 // Core materials
 json get_core_materials();
 double get_material_permeability(json materialName, double temperature, double magneticFieldDcBias, double frequency);
+py::array_t<double> get_material_permeability_batch(json materialName, py::array_t<double> temperatures, py::array_t<double> magneticFieldDcBiases, py::array_t<double> frequencies);
 double get_material_resistivity(json materialName, double temperature);
 json get_core_material_steinmetz_coefficients(json materialName, double frequency);
 json get_core_material_names();
@@ -27,6 +29,10 @@ std::vector<std::string> get_available_shape_families();
 std::vector<std::string> get_available_core_shape_families();
 std::vector<std::string> get_available_core_shapes();
 json get_available_cores();
+py::dict get_core_catalog_table();
+json query_cores(json rangesJson, json filtersJson, std::vector<std::string> fields);
+py::dict get_core_energy_map_table(std::vector<double> temperatures);
+json query_cores_by_energy(double requiredEnergy, double temperature, size_t maximumResults);
 
 // Core calculations
 json calculate_core_data(json coreDataJson, bool includeMaterialData);
@@ -34,15 +40,19 @@ json calculate_core_processed_description(json coreDataJson);
 json calculate_core_geometrical_description(json coreDataJson);
 json calculate_core_gapping(json coreDataJson);
 json load_core_data(json coresJson);
+json calculate_core_data_batch(std::vector<json> coresJson, bool includeMaterialData, std::string output);
 json get_core_temperature_dependant_parameters(json coreData, double temperature);
+py::dict get_core_temperature_dependant_parameters_sweep(json coreData, py::array_t<double, py::array::c_style | py::array::forcecast> temperatures, bool releaseGil);
 double calculate_core_maximum_magnetic_energy(json coreDataJson, json operatingPointJson);
 double calculate_saturation_current(json magneticJson, double temperature);
 double calculate_temperature_from_core_thermal_resistance(json coreJson, double totalLosses);
 
 // Gap and reluctance
 json calculate_gap_reluctance(json coreGapData, std::string modelNameString);
+py::dict calculate_gap_reluctance_batch(std::vector<json> coreGapsData, std::vector<std::string> modelNames);
 json get_gap_reluctance_model_information();
 double calculate_inductance_from_number_turns_and_gapping(json coreData, json coilData, json operatingPointData, json modelsData);
+py::dict calculate_inductance_sweep(json coreData, json coilData, json operatingPointData, std::vector<int64_t> numbersTurns, std::vector<double> gapLengths, std::vector<std::string> reluctanceModelNames);
 double calculate_number_turns_from_gapping_and_inductance(json coreData, json inputsData, json modelsData);
 json calculate_gapping_from_number_turns_and_inductance(json coreData, json coilData, json inputsData, std::string gappingTypeJson, int decimals, json modelsData);
 
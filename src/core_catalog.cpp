@@ -0,0 +1,273 @@
+#include "core_catalog.h"
+#include "database.h"
+#include "lazy_database.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace PyMKF {
+
+namespace {
+
+constexpr double notAvailable = std::numeric_limits<double>::quiet_NaN();
+
+std::mutex coreCatalogMutex;
+std::shared_ptr<const CoreCatalog> currentCoreCatalog;
+uint64_t coreCatalogDatabaseVersion = 0;
+size_t coreCatalogDatabaseSize = 0;
+
+std::string get_material_name(const OpenMagnetics::Core& core) {
+    auto material = core.get_functional_description().get_material();
+    if (std::holds_alternative<std::string>(material)) {
+        return std::get<std::string>(material);
+    }
+    return std::get<CoreMaterial>(material).get_name();
+}
+
+std::string get_shape_name(const OpenMagnetics::Core& core) {
+    auto shape = core.get_functional_description().get_shape();
+    if (std::holds_alternative<std::string>(shape)) {
+        return std::get<std::string>(shape);
+    }
+    return std::get<CoreShape>(shape).get_name().value_or("");
+}
+
+std::string get_family_name(const OpenMagnetics::Core& core) {
+    auto shape = core.get_functional_description().get_shape();
+    CoreShapeFamily family;
+    if (std::holds_alternative<std::string>(shape)) {
+        try {
+            family = OpenMagnetics::find_core_shape_by_name(std::get<std::string>(shape)).get_family();
+        }
+        catch (const std::exception&) {
+            return "";
+        }
+    }
+    else {
+        family = std::get<CoreShape>(shape).get_family();
+    }
+    json familyJson;
+    to_json(familyJson, family);
+    return familyJson.get<std::string>();
+}
+
+std::string get_manufacturer_name(const OpenMagnetics::Core& core) {
+    if (core.get_manufacturer_info()) {
+        return core.get_manufacturer_info()->get_name();
+    }
+    return "";
+}
+
+std::string normalize_family_name(std::string name) {
+    for (auto& character : name) {
+        character = character == '_' ? ' ' : static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+    }
+    return name;
+}
+
+// Which ids of a name list are accepted, empty when every id is
+std::vector<bool> get_accepted_ids(const std::vector<std::string>& names, const std::vector<std::string>& accepted, bool normalize) {
+    std::vector<bool> acceptedIds;
+    if (accepted.empty()) {
+        return acceptedIds;
+    }
+    acceptedIds.resize(names.size(), false);
+    for (auto name : accepted) {
+        if (normalize) {
+            name = normalize_family_name(name);
+        }
+        for (size_t id = 0; id < names.size(); ++id) {
+            if (names[id] == name || (normalize && normalize_family_name(names[id]) == name)) {
+                acceptedIds[id] = true;
+            }
+        }
+    }
+    return acceptedIds;
+}
+
+bool is_accepted(const std::vector<bool>& acceptedIds, int64_t id) {
+    return acceptedIds.empty() || acceptedIds[static_cast<size_t>(id)];
+}
+
+std::string get_reference(const OpenMagnetics::Core& core) {
+    if (core.get_manufacturer_info() && core.get_manufacturer_info()->get_reference()) {
+        return core.get_manufacturer_info()->get_reference().value();
+    }
+    return core.get_name().value_or("");
+}
+
+int64_t get_id(std::map<std::string, int64_t>& ids, std::vector<std::string>& names, const std::string& name) {
+    auto [it, inserted] = ids.try_emplace(name, static_cast<int64_t>(names.size()));
+    if (inserted) {
+        names.push_back(name);
+    }
+    return it->second;
+}
+
+std::shared_ptr<const CoreCatalog> build_core_catalog() {
+    auto catalog = std::make_shared<CoreCatalog>();
+    std::map<std::string, int64_t> materialIds;
+    std::map<std::string, int64_t> shapeIds;
+    std::map<std::string, int64_t> familyIds;
+    std::map<std::string, int64_t> manufacturerIds;
+    std::map<std::string, std::string> familyByShape;
+    std::map<std::string, double> densities;
+
+    for (auto& core : OpenMagnetics::coreDatabase) {
+        catalog->references.push_back(get_reference(core));
+        auto materialName = get_material_name(core);
+        catalog->materialIds.push_back(get_id(materialIds, catalog->materialNames, materialName));
+        auto shapeName = get_shape_name(core);
+        catalog->shapeIds.push_back(get_id(shapeIds, catalog->shapeNames, shapeName));
+        auto family = familyByShape.find(shapeName);
+        if (family == familyByShape.end()) {
+            family = familyByShape.emplace(shapeName, get_family_name(core)).first;
+        }
+        catalog->familyIds.push_back(get_id(familyIds, catalog->familyNames, family->second));
+        catalog->manufacturerIds.push_back(get_id(manufacturerIds, catalog->manufacturerNames, get_manufacturer_name(core)));
+        catalog->numberStacks.push_back(core.get_functional_description().get_number_stacks().value_or(1));
+
+        if (!core.get_processed_description()) {
+            for (auto column : {&catalog->effectiveArea, &catalog->effectiveLength, &catalog->effectiveVolume, &catalog->windingWindowArea, &catalog->columnArea, &catalog->areaProduct, &catalog->height, &catalog->estimatedMass}) {
+                column->push_back(notAvailable);
+            }
+            continue;
+        }
+        auto& processedDescription = core.get_processed_description().value();
+        auto& effectiveParameters = processedDescription.get_effective_parameters();
+        catalog->effectiveArea.push_back(effectiveParameters.get_effective_area());
+        catalog->effectiveLength.push_back(effectiveParameters.get_effective_length());
+        catalog->effectiveVolume.push_back(effectiveParameters.get_effective_volume());
+
+        auto& windingWindows = processedDescription.get_winding_windows();
+        double windingWindowArea = !windingWindows.empty() && windingWindows[0].get_area() ? windingWindows[0].get_area().value() : notAvailable;
+        auto& columns = processedDescription.get_columns();
+        double columnArea = !columns.empty() ? columns[0].get_area() : notAvailable;
+        catalog->windingWindowArea.push_back(windingWindowArea);
+        catalog->columnArea.push_back(columnArea);
+        catalog->areaProduct.push_back(windingWindowArea * columnArea);
+        catalog->height.push_back(processedDescription.get_height());
+
+        auto density = densities.find(materialName);
+        if (density == densities.end()) {
+            double materialDensity = notAvailable;
+            try {
+                auto material = OpenMagnetics::find_core_material_by_name(materialName);
+                if (material.get_density()) {
+                    materialDensity = material.get_density().value();
+                }
+            }
+            catch (const std::exception&) {
+                // Cores may name materials that are not in the database
+            }
+            density = densities.emplace(materialName, materialDensity).first;
+        }
+        catalog->estimatedMass.push_back(density->second * effectiveParameters.get_effective_volume());
+    }
+    catalog->build_indexes();
+    return catalog;
+}
+
+} // namespace
+
+const std::vector<double>& CoreCatalog::get_column(CoreCatalogKey key) const {
+    switch (key) {
+        case CoreCatalogKey::AREA_PRODUCT: return areaProduct;
+        case CoreCatalogKey::EFFECTIVE_AREA: return effectiveArea;
+        case CoreCatalogKey::EFFECTIVE_VOLUME: return effectiveVolume;
+        case CoreCatalogKey::WINDING_WINDOW_AREA: return windingWindowArea;
+        case CoreCatalogKey::HEIGHT: return height;
+    }
+    throw std::invalid_argument("Unknown core catalog key");
+}
+
+void CoreCatalog::build_indexes() {
+    for (size_t keyIndex = 0; keyIndex < numberCoreCatalogKeys; ++keyIndex) {
+        auto& column = get_column(static_cast<CoreCatalogKey>(keyIndex));
+        auto& rows = sortedRows[keyIndex];
+        rows.clear();
+        for (size_t row = 0; row < column.size(); ++row) {
+            if (!std::isnan(column[row])) {
+                rows.push_back(static_cast<uint32_t>(row));
+            }
+        }
+        std::stable_sort(rows.begin(), rows.end(), [&column](uint32_t a, uint32_t b) {
+            return column[a] < column[b];
+        });
+    }
+}
+
+std::vector<size_t> CoreCatalog::query(const std::vector<CoreCatalogRange>& ranges, const CoreCatalogFilter& filter) const {
+    auto acceptedMaterials = get_accepted_ids(materialNames, filter.materials, false);
+    auto acceptedFamilies = get_accepted_ids(familyNames, filter.families, true);
+    auto acceptedManufacturers = get_accepted_ids(manufacturerNames, filter.manufacturers, false);
+
+    // Candidates come from the narrowest range, the other ranges are checked row by row
+    const uint32_t* first = nullptr;
+    const uint32_t* last = nullptr;
+    for (auto& range : ranges) {
+        auto& column = get_column(range.key);
+        auto& rows = sortedRows[static_cast<size_t>(range.key)];
+        auto lower = std::lower_bound(rows.begin(), rows.end(), range.minimum, [&column](uint32_t row, double value) {
+            return column[row] < value;
+        });
+        auto upper = std::upper_bound(lower, rows.end(), range.maximum, [&column](double value, uint32_t row) {
+            return value < column[row];
+        });
+        if (range.minimum > range.maximum) {
+            upper = lower;
+        }
+        if (!first || upper - lower < last - first) {
+            first = rows.data() + (lower - rows.begin());
+            last = rows.data() + (upper - rows.begin());
+        }
+    }
+
+    auto matches = [&](size_t row) {
+        for (auto& range : ranges) {
+            double value = get_column(range.key)[row];
+            if (!(value >= range.minimum && value <= range.maximum)) {
+                return false;
+            }
+        }
+        return is_accepted(acceptedMaterials, materialIds[row]) &&
+               is_accepted(acceptedFamilies, familyIds[row]) &&
+               is_accepted(acceptedManufacturers, manufacturerIds[row]);
+    };
+
+    std::vector<size_t> result;
+    if (first) {
+        for (auto row = first; row != last; ++row) {
+            if (matches(*row)) {
+                result.push_back(*row);
+            }
+        }
+        std::sort(result.begin(), result.end());
+    }
+    else {
+        for (size_t row = 0; row < size(); ++row) {
+            if (matches(row)) {
+                result.push_back(row);
+            }
+        }
+    }
+    return result;
+}
+
+std::shared_ptr<const CoreCatalog> get_core_catalog() {
+    std::lock_guard<std::mutex> lock(coreCatalogMutex);
+    materialize_all_records();
+    if (OpenMagnetics::coreDatabase.empty()) {
+        OpenMagnetics::load_cores();
+    }
+    // The size catches OpenMagnetics loading its default cores on first use behind our back
+    if (currentCoreCatalog && coreCatalogDatabaseVersion == get_database_version() && coreCatalogDatabaseSize == OpenMagnetics::coreDatabase.size()) {
+        return currentCoreCatalog;
+    }
+    coreCatalogDatabaseVersion = get_database_version();
+    coreCatalogDatabaseSize = OpenMagnetics::coreDatabase.size();
+    currentCoreCatalog = build_core_catalog();
+    return currentCoreCatalog;
+}
+
+} // namespace PyMKF
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "common.h"
+#include <array>
+#include <memory>
+
+namespace PyMKF {
+
+// Columns that can be range-queried
+enum class CoreCatalogKey { AREA_PRODUCT, EFFECTIVE_AREA, EFFECTIVE_VOLUME, WINDING_WINDOW_AREA, HEIGHT };
+constexpr size_t numberCoreCatalogKeys = 5;
+
+// Closed interval, use infinities for open ends
+struct CoreCatalogRange {
+    CoreCatalogKey key;
+    double minimum;
+    double maximum;
+};
+
+// A core passes when each non-empty list contains its name. Family names are compared
+// case-insensitively, with '_' and ' ' equivalent, so both "PLANAR_E" and "planar e" work.
+struct CoreCatalogFilter {
+    std::vector<std::string> materials;
+    std::vector<std::string> families;
+    std::vector<std::string> manufacturers;
+};
+
+// Numeric columns over OpenMagnetics::coreDatabase, one row per core in database order.
+// Values that a core does not define are NaN. Materials, shapes, families and manufacturers
+// are stored as ids into the matching name lists.
+struct CoreCatalog {
+    std::vector<std::string> references;
+    std::vector<double> effectiveArea;
+    std::vector<double> effectiveLength;
+    std::vector<double> effectiveVolume;
+    std::vector<double> windingWindowArea;
+    std::vector<double> columnArea;
+    std::vector<double> areaProduct;
+    std::vector<double> height;
+    // Material density times effective volume; Ve follows the magnetic path, so this only approximates the physical mass
+    std::vector<double> estimatedMass;
+    std::vector<int64_t> numberStacks;
+    std::vector<int64_t> materialIds;
+    std::vector<int64_t> shapeIds;
+    std::vector<int64_t> familyIds;
+    std::vector<int64_t> manufacturerIds;
+    std::vector<std::string> materialNames;
+    std::vector<std::string> shapeNames;
+    std::vector<std::string> familyNames;
+    std::vector<std::string> manufacturerNames;
+
+    // Rows sorted by each CoreCatalogKey column, rows where the column is NaN left out
+    std::array<std::vector<uint32_t>, numberCoreCatalogKeys> sortedRows;
+
+    size_t size() const { return references.size(); }
+    const std::vector<double>& get_column(CoreCatalogKey key) const;
+    void build_indexes();
+    // Rows inside every range that pass the filter, in database order. Scans only the rows of
+    // the most selective range, found by binary search.
+    std::vector<size_t> query(const std::vector<CoreCatalogRange>& ranges, const CoreCatalogFilter& filter) const;
+};
+
+// Catalog of the current core database, rebuilt the first time it is requested after a load,
+// reload or clear. The returned pointer stays valid for the caller even if the databases change.
+std::shared_ptr<const CoreCatalog> get_core_catalog();
+
+} // namespace PyMKF
@@ -0,0 +1,106 @@
+#include "core_energy_map.h"
+#include "core_catalog.h"
+#include "database.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace PyMKF {
+
+namespace {
+
+const std::vector<double> defaultCoreEnergyMapTemperatures = {25, 100};
+
+std::mutex coreEnergyMapMutex;
+std::shared_ptr<const CoreEnergyMap> currentCoreEnergyMap;
+uint64_t coreEnergyMapDatabaseVersion = 0;
+size_t coreEnergyMapDatabaseSize = 0;
+
+std::shared_ptr<const CoreEnergyMap> build_core_energy_map(std::vector<double> temperatures) {
+    auto map = std::make_shared<CoreEnergyMap>();
+    map->temperatures = std::move(temperatures);
+    auto& cores = OpenMagnetics::coreDatabase;
+    map->references = get_core_catalog()->references;
+    map->maximumMagneticEnergy.assign(map->temperatures.size(), std::vector<double>(cores.size(), std::numeric_limits<double>::quiet_NaN()));
+    map->saturationAmpereTurns.assign(map->temperatures.size(), std::vector<double>(cores.size(), std::numeric_limits<double>::quiet_NaN()));
+
+    parallel_for(cores.size(), [&](size_t row) {
+        try {
+            auto core = cores[row];
+            if (!core.get_processed_description()) {
+                core.process_data();
+                core.process_gap();
+            }
+            double effectiveArea = core.get_processed_description()->get_effective_parameters().get_effective_area();
+            for (size_t temperatureIndex = 0; temperatureIndex < map->temperatures.size(); ++temperatureIndex) {
+                double temperature = map->temperatures[temperatureIndex];
+                double saturationFlux = core.get_magnetic_flux_density_saturation(temperature, false) * effectiveArea;
+                double reluctance = core.get_reluctance(temperature);
+                map->maximumMagneticEnergy[temperatureIndex][row] = saturationFlux * saturationFlux * reluctance / 2;
+                map->saturationAmpereTurns[temperatureIndex][row] = saturationFlux * reluctance;
+            }
+        }
+        catch (const std::exception &) {
+        }
+    });
+
+    for (auto& energies : map->maximumMagneticEnergy) {
+        std::vector<uint32_t> rows;
+        for (uint32_t row = 0; row < energies.size(); ++row) {
+            if (!std::isnan(energies[row])) {
+                rows.push_back(row);
+            }
+        }
+        std::stable_sort(rows.begin(), rows.end(), [&](uint32_t a, uint32_t b) { return energies[a] < energies[b]; });
+        map->sortedRows.push_back(std::move(rows));
+    }
+    return map;
+}
+
+} // namespace
+
+size_t CoreEnergyMap::get_temperature_index(double temperature) const {
+    size_t best = temperatures.size();
+    for (size_t index = 0; index < temperatures.size(); ++index) {
+        if (temperatures[index] >= temperature && (best == temperatures.size() || temperatures[index] < temperatures[best])) {
+            best = index;
+        }
+    }
+    if (best == temperatures.size()) {
+        throw std::invalid_argument("No precomputed temperature at or above " + std::to_string(temperature));
+    }
+    return best;
+}
+
+std::vector<size_t> CoreEnergyMap::query(double requiredEnergy, size_t temperatureIndex, size_t maximumResults) const {
+    auto& rows = sortedRows[temperatureIndex];
+    auto& energies = maximumMagneticEnergy[temperatureIndex];
+    auto first = std::lower_bound(rows.begin(), rows.end(), requiredEnergy, [&](uint32_t row, double energy) { return energies[row] < energy; });
+    auto last = maximumResults > 0 && static_cast<size_t>(rows.end() - first) > maximumResults ? first + maximumResults : rows.end();
+    return std::vector<size_t>(first, last);
+}
+
+void load_core_energy_map_databases() {
+    ensure_databases_loaded();
+    if (OpenMagnetics::coreDatabase.empty()) {
+        OpenMagnetics::load_cores();
+    }
+}
+
+std::shared_ptr<const CoreEnergyMap> get_core_energy_map(std::vector<double> temperatures) {
+    std::lock_guard<std::mutex> lock(coreEnergyMapMutex);
+    if (temperatures.empty()) {
+        temperatures = currentCoreEnergyMap ? currentCoreEnergyMap->temperatures : defaultCoreEnergyMapTemperatures;
+    }
+    if (currentCoreEnergyMap && currentCoreEnergyMap->temperatures == temperatures &&
+        coreEnergyMapDatabaseVersion == get_database_version() && coreEnergyMapDatabaseSize == OpenMagnetics::coreDatabase.size()) {
+        return currentCoreEnergyMap;
+    }
+    coreEnergyMapDatabaseVersion = get_database_version();
+    coreEnergyMapDatabaseSize = OpenMagnetics::coreDatabase.size();
+    currentCoreEnergyMap = build_core_energy_map(std::move(temperatures));
+    return currentCoreEnergyMap;
+}
+
+} // namespace PyMKF
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "common.h"
+#include <memory>
+
+namespace PyMKF {
+
+// Maximum storable magnetic energy and saturation ampere-turns of every core of
+// OpenMagnetics::coreDatabase at a set of temperatures, one row per core in database order.
+// With the saturation flux Phi = Bsat * Ae and the total reluctance R of the core, gaps included,
+// the energy is Phi^2 * R / 2 and the ampere-turns are Phi * R. The saturation current of a
+// winding of N turns is then ampere-turns / N, and the energy does not depend on N.
+struct CoreEnergyMap {
+    std::vector<double> temperatures;
+    std::vector<std::string> references;
+    // Indexed [temperature][core], NaN where the core could not be evaluated
+    std::vector<std::vector<double>> maximumMagneticEnergy;
+    std::vector<std::vector<double>> saturationAmpereTurns;
+    // Per temperature, rows by increasing maximum magnetic energy, NaN rows left out
+    std::vector<std::vector<uint32_t>> sortedRows;
+
+    size_t size() const { return references.size(); }
+    // Index of the first temperature not below temperature, the conservative choice as saturation
+    // drops with temperature. Throws if temperature is above all of them.
+    size_t get_temperature_index(double temperature) const;
+    // Rows able to store at least requiredEnergy, by increasing energy, at most maximumResults
+    // of them unless it is 0
+    std::vector<size_t> query(double requiredEnergy, size_t temperatureIndex, size_t maximumResults) const;
+};
+
+// Loads every database the map is built from. Called with the GIL held, before get_core_energy_map,
+// which only reads them and so can run with the GIL released.
+void load_core_energy_map_databases();
+
+// Map at the given temperatures, or at the temperatures of the last map when empty. Built in
+// parallel and kept until the temperatures change or the databases are loaded, reloaded or cleared.
+std::shared_ptr<const CoreEnergyMap> get_core_energy_map(std::vector<double> temperatures);
+
+} // namespace PyMKF
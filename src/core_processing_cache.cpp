@@ -0,0 +1,136 @@
+#include "core_processing_cache.h"
+#include "database.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace PyMKF {
+
+namespace {
+
+struct CoreProcessingCacheEntry {
+    std::string key;
+    CoreProcessedDescription processedDescription;
+    std::vector<CoreGap> gapping;
+    std::optional<std::vector<CoreGeometricalDescriptionElement>> geometricalDescription;
+};
+
+std::mutex coreProcessingCacheMutex;
+size_t coreProcessingCacheMaximumEntries = 1024;
+uint64_t coreProcessingCacheDatabaseVersion = 0;
+// Most recently used first, the index points into the list and keys into its entries
+std::list<CoreProcessingCacheEntry> coreProcessingCacheEntries;
+std::unordered_map<std::string_view, std::list<CoreProcessingCacheEntry>::iterator> coreProcessingCacheIndex;
+std::atomic<uint64_t> coreProcessingCacheHits{0};
+std::atomic<uint64_t> coreProcessingCacheMisses{0};
+std::atomic<uint64_t> coreProcessingCacheEvictions{0};
+
+// Caller must hold coreProcessingCacheMutex
+void clear_entries() {
+    coreProcessingCacheIndex.clear();
+    coreProcessingCacheEntries.clear();
+}
+
+// Caller must hold coreProcessingCacheMutex
+void evict_entries() {
+    while (coreProcessingCacheEntries.size() > coreProcessingCacheMaximumEntries) {
+        coreProcessingCacheIndex.erase(coreProcessingCacheEntries.back().key);
+        coreProcessingCacheEntries.pop_back();
+        ++coreProcessingCacheEvictions;
+    }
+}
+
+// Dumped with sorted keys, so equal descriptions always give the same text
+std::string get_key(const OpenMagnetics::Core& core) {
+    json functionalDescription;
+    to_json(functionalDescription, core.get_functional_description());
+    functionalDescription.erase("name");
+    auto& material = functionalDescription["material"];
+    if (material.is_object()) {
+        material = material.value("name", material.dump());
+    }
+    return functionalDescription.dump();
+}
+
+} // namespace
+
+void process_core(OpenMagnetics::Core& core) {
+    if (core.get_processed_description() || core.get_geometrical_description()) {
+        if (!core.get_processed_description()) {
+            core.process_data();
+            core.process_gap();
+        }
+        if (!core.get_geometrical_description()) {
+            auto geometricalDescription = core.create_geometrical_description();
+            core.set_geometrical_description(geometricalDescription);
+        }
+        return;
+    }
+
+    auto key = get_key(core);
+    uint64_t databaseVersion = get_database_version();
+    {
+        std::lock_guard<std::mutex> lock(coreProcessingCacheMutex);
+        if (coreProcessingCacheDatabaseVersion != databaseVersion) {
+            clear_entries();
+            coreProcessingCacheDatabaseVersion = databaseVersion;
+        }
+        auto cached = coreProcessingCacheIndex.find(key);
+        if (cached != coreProcessingCacheIndex.end()) {
+            coreProcessingCacheEntries.splice(coreProcessingCacheEntries.begin(), coreProcessingCacheEntries, cached->second);
+            auto& entry = *cached->second;
+            core.set_processed_description(entry.processedDescription);
+            core.get_mutable_functional_description().set_gapping(entry.gapping);
+            core.set_geometrical_description(entry.geometricalDescription);
+            ++coreProcessingCacheHits;
+            return;
+        }
+    }
+
+    // Processed outside the lock, two threads missing on the same key just both compute it
+    ++coreProcessingCacheMisses;
+    core.process_data();
+    core.process_gap();
+    auto geometricalDescription = core.create_geometrical_description();
+    core.set_geometrical_description(geometricalDescription);
+
+    std::lock_guard<std::mutex> lock(coreProcessingCacheMutex);
+    if (coreProcessingCacheMaximumEntries == 0 || coreProcessingCacheDatabaseVersion != databaseVersion || coreProcessingCacheIndex.contains(key)) {
+        return;
+    }
+    coreProcessingCacheEntries.push_front({std::move(key), core.get_processed_description().value(), core.get_functional_description().get_gapping(), geometricalDescription});
+    coreProcessingCacheIndex.emplace(coreProcessingCacheEntries.front().key, coreProcessingCacheEntries.begin());
+    evict_entries();
+}
+
+std::string set_core_processing_cache_size(size_t maximumEntries) {
+    std::lock_guard<std::mutex> lock(coreProcessingCacheMutex);
+    coreProcessingCacheMaximumEntries = maximumEntries;
+    evict_entries();
+    return "0";
+}
+
+std::string clear_core_processing_cache() {
+    std::lock_guard<std::mutex> lock(coreProcessingCacheMutex);
+    clear_entries();
+    coreProcessingCacheHits = 0;
+    coreProcessingCacheMisses = 0;
+    coreProcessingCacheEvictions = 0;
+    return "0";
+}
+
+json get_core_processing_cache_statistics() {
+    std::lock_guard<std::mutex> lock(coreProcessingCacheMutex);
+    json statistics;
+    statistics["entries"] = coreProcessingCacheEntries.size();
+    statistics["maximumEntries"] = coreProcessingCacheMaximumEntries;
+    statistics["hits"] = coreProcessingCacheHits.load();
+    statistics["misses"] = coreProcessingCacheMisses.load();
+    statistics["evictions"] = coreProcessingCacheEvictions.load();
+    uint64_t lookups = coreProcessingCacheHits.load() + coreProcessingCacheMisses.load();
+    statistics["hitRate"] = lookups > 0 ? static_cast<double>(coreProcessingCacheHits.load()) / lookups : 0.0;
+    return statistics;
+}
+
+} // namespace PyMKF
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "common.h"
+
+namespace PyMKF {
+
+// Process-wide memo of core processing. Entries hold the processed description, processed gapping
+// and geometrical description that process_data(), process_gap() and
+// create_geometrical_description() produce, keyed by the functional description with the
+// material reduced to its name and the core name left out. Least recently used entries are
+// evicted beyond the capacity, and everything is dropped when the databases are reloaded.
+
+// Fills whatever core is missing of its processed description, processed gapping and geometrical
+// description, from the cache when possible. Cores that arrive already processed are completed
+// without the cache. Safe to call from several threads at once.
+void process_core(OpenMagnetics::Core& core);
+
+// 0 disables the cache
+std::string set_core_processing_cache_size(size_t maximumEntries);
+std::string clear_core_processing_cache();
+json get_core_processing_cache_statistics();
+
+} // namespace PyMKF
@@ -1,68 +1,712 @@
 #include "database.h"
+#include "autocomplete_cache.h"
+#include "fuzzy_index.h"
+#include "lazy_database.h"
+#include "mapped_file.h"
+#include "mas_store.h"
+#include "memory_usage.h"
+#include "ndjson.h"
+#include "parallel.h"
+#include "string_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#ifndef MAS_REVISION
+#define MAS_REVISION unknown
+#endif
 
 namespace PyMKF {
 
-// Definition of the masDatabase variable (declared as extern in common.h)
-std::map<std::string, OpenMagnetics::Mas> masDatabase;
+// Definition of the masDatabase variable (declared as extern in mas_store.h)
+MasStore masDatabase;
+
+namespace {
+
+// Snapshot layout: header, section table, and per section a record table followed by
+// the record names and their MessagePack encoded data. Offsets are absolute in the file
+// and tables are 8-byte aligned so the file can be used directly from a read-only mapping.
+constexpr char snapshotMagic[8] = {'P', 'Y', 'M', 'K', 'F', 'D', 'B', '\0'};
+constexpr uint32_t snapshotByteOrderMark = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t schemaVersion;
+    uint32_t byteOrderMark;
+    char masRevision[64];
+    uint64_t numberSections;
+    uint64_t sectionTableOffset;
+    uint64_t databaseFingerprint;
+};
+
+struct SnapshotSection {
+    char name[32];
+    uint64_t numberRecords;
+    uint64_t recordTableOffset;
+};
+
+struct SnapshotRecord {
+    uint64_t nameOffset;
+    uint64_t nameSize;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+constexpr size_t snapshotNumberSections = 6;
+
+template <typename T>
+void write_at(std::string& buffer, size_t offset, const T& value) {
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T read_at(const MappedFile& file, uint64_t offset) {
+    if (offset + sizeof(T) > file.size()) {
+        throw std::runtime_error("Snapshot is truncated");
+    }
+    T value;
+    std::memcpy(&value, file.data() + offset, sizeof(T));
+    return value;
+}
+
+void align_buffer(std::string& buffer) {
+    buffer.resize((buffer.size() + 7) & ~size_t(7), '\0');
+}
+
+template <typename Database>
+SnapshotSection write_snapshot_section(std::string& buffer, std::string sectionName, const Database& database) {
+    SnapshotSection section{};
+    std::strncpy(section.name, sectionName.c_str(), sizeof(section.name) - 1);
+    section.numberRecords = database.size();
+
+    align_buffer(buffer);
+    section.recordTableOffset = buffer.size();
+    buffer.resize(buffer.size() + database.size() * sizeof(SnapshotRecord), '\0');
+
+    size_t recordIndex = 0;
+    for (auto& [name, record] : database) {
+        json recordJson;
+        to_json(recordJson, record);
+        auto data = json::to_msgpack(recordJson);
+
+        SnapshotRecord snapshotRecord;
+        snapshotRecord.nameOffset = buffer.size();
+        snapshotRecord.nameSize = name.size();
+        buffer.append(name);
+        snapshotRecord.dataOffset = buffer.size();
+        snapshotRecord.dataSize = data.size();
+        buffer.append(reinterpret_cast<const char*>(data.data()), data.size());
+
+        write_at(buffer, section.recordTableOffset + recordIndex * sizeof(SnapshotRecord), snapshotRecord);
+        recordIndex++;
+    }
+    return section;
+}
+
+// Name and MessagePack data of every record of a section, pointing into the mapping
+SnapshotRecordViews read_snapshot_record_views(const MappedFile& file, const SnapshotSection& section) {
+    SnapshotRecordViews records;
+    records.reserve(section.numberRecords);
+    for (uint64_t recordIndex = 0; recordIndex < section.numberRecords; ++recordIndex) {
+        auto snapshotRecord = read_at<SnapshotRecord>(file, section.recordTableOffset + recordIndex * sizeof(SnapshotRecord));
+        if (snapshotRecord.nameOffset + snapshotRecord.nameSize > file.size() || snapshotRecord.dataOffset + snapshotRecord.dataSize > file.size()) {
+            throw std::runtime_error("Snapshot is truncated");
+        }
+        records.emplace_back(std::string_view(file.data() + snapshotRecord.nameOffset, snapshotRecord.nameSize),
+                             std::string_view(file.data() + snapshotRecord.dataOffset, snapshotRecord.dataSize));
+    }
+    return records;
+}
+
+template <typename Database>
+Database read_snapshot_section(const SnapshotRecordViews& records) {
+    using Record = typename Database::mapped_type;
+    Database database;
+    for (auto& [name, data] : records) {
+        auto bytes = reinterpret_cast<const uint8_t*>(data.data());
+        json recordJson = json::from_msgpack(bytes, bytes + data.size());
+        Record record(recordJson);
+        database.insert_or_assign(std::string(name), record);
+    }
+    return database;
+}
+
+// Chunks smaller than this are not worth a task of their own
+constexpr size_t minimumNdjsonChunkSize = 256 * 1024;
+
+struct NdjsonChunk {
+    size_t fileIndex;
+    size_t begin;
+    size_t end;
+};
+
+// What was loaded from one ndjson file: its modification time and size for a quick change check,
+// a hash of its records for a thorough one, and every record's line hash and aliases to diff against
+struct LoadedRecord {
+    uint64_t lineHash;
+    std::vector<std::string_view> aliases;
+};
+
+struct LoadedFile {
+    bool found = false;
+    std::filesystem::file_time_type modificationTime;
+    size_t size = 0;
+    uint64_t hash = hash_text("");
+    // Names and aliases are interned in stringPool
+    std::unordered_map<std::string_view, LoadedRecord> records;
+};
+
+struct NdjsonIngestion {
+    json data;
+    json statistics;
+    std::vector<LoadedFile> files;
+};
 
-void load_databases(json databasesJson) {
+// Baseline reload_databases diffs against, reset whenever the databases are replaced some other way
+std::filesystem::path loadedDatabasesPath;
+std::vector<LoadedFile> loadedFiles(ndjsonDatabaseFiles.size());
+
+void reset_reload_baseline() {
+    loadedDatabasesPath.clear();
+    loadedFiles.assign(ndjsonDatabaseFiles.size(), LoadedFile());
+}
+
+// Returns the record's name
+std::string add_loaded_record(LoadedFile& file, const NdjsonRecord& record) {
+    std::string name = record.document.at("name");
+    LoadedRecord loadedRecord{record.lineHash, {}};
+    if (record.document.contains("aliases") && record.document["aliases"].is_array()) {
+        for (auto& alias : record.document["aliases"]) {
+            if (alias.is_string()) {
+                loadedRecord.aliases.push_back(stringPool.intern(alias.get_ref<const std::string&>()));
+            }
+        }
+    }
+    file.records.insert_or_assign(stringPool.intern(name), std::move(loadedRecord));
+    file.hash = hash_text(std::string_view(reinterpret_cast<const char*>(&record.lineHash), sizeof(record.lineHash)), file.hash);
+    return name;
+}
+
+json lastIngestionStatistics = json::object();
+
+std::atomic<uint64_t> databaseVersion{0};
+std::atomic<uint64_t> databaseFingerprint{0};
+
+void bump_database_version() {
+    databaseVersion.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void set_database_fingerprint(uint64_t fingerprint) {
+    databaseFingerprint.store(fingerprint, std::memory_order_release);
+}
+
+// For loads that go on top of what is already loaded
+void mix_database_fingerprint(std::string_view text) {
+    set_database_fingerprint(hash_text(text, get_database_fingerprint()));
+}
+
+// Contents of a file loaded through MKF, or its path when it cannot be read here
+std::string hash_file(const std::string& path) {
+    try {
+        MappedFile file(path);
+        return std::to_string(hash_text(file.view()));
+    }
+    catch (const std::exception &) {
+        return path;
+    }
+}
+
+uint64_t hash_loaded_files(uint64_t hash) {
+    for (auto& file : loadedFiles) {
+        hash = hash_text(std::string_view(reinterpret_cast<const char*>(&file.hash), sizeof(file.hash)), hash);
+    }
+    return hash;
+}
+
+// Parses every database file of a MAS data folder. All files are split into line-aligned chunks
+// that are parsed on the worker threads, then merged in file, chunk and line order so the result
+// is identical to reading the files one after another.
+NdjsonIngestion ingest_ndjson_databases(const std::filesystem::path& masPath) {
+    using Clock = std::chrono::steady_clock;
+
+    NdjsonIngestion ingestion;
+    ingestion.files.resize(ndjsonDatabaseFiles.size());
+    std::vector<std::optional<MappedFile>> files(ndjsonDatabaseFiles.size());
+    size_t totalSize = 0;
+    for (size_t fileIndex = 0; fileIndex < ndjsonDatabaseFiles.size(); ++fileIndex) {
+        auto filePath = masPath / ndjsonDatabaseFiles[fileIndex].second;
+        if (std::filesystem::exists(filePath)) {
+            // Taken before reading, so an edit made while loading shows up on the next reload
+            ingestion.files[fileIndex].modificationTime = std::filesystem::last_write_time(filePath);
+            files[fileIndex].emplace(filePath);
+            ingestion.files[fileIndex].found = true;
+            ingestion.files[fileIndex].size = files[fileIndex]->size();
+            totalSize += files[fileIndex]->size();
+        }
+    }
+    size_t targetChunkSize = std::max(minimumNdjsonChunkSize, totalSize / (get_number_threads() * 4) + 1);
+
+    std::vector<NdjsonChunk> chunks;
+    for (size_t fileIndex = 0; fileIndex < files.size(); ++fileIndex) {
+        if (!files[fileIndex]) {
+            continue;
+        }
+        for (auto [begin, end] : split_ndjson_lines(files[fileIndex]->view(), targetChunkSize)) {
+            chunks.push_back({fileIndex, begin, end});
+        }
+    }
+
+    std::vector<std::vector<NdjsonRecord>> chunkRecords(chunks.size());
+    std::vector<Clock::time_point> chunkStarts(chunks.size());
+    std::vector<Clock::time_point> chunkEnds(chunks.size());
+    parallel_for(chunks.size(), [&](size_t chunkIndex) {
+        auto& chunk = chunks[chunkIndex];
+        chunkStarts[chunkIndex] = Clock::now();
+        auto text = files[chunk.fileIndex]->view().substr(chunk.begin, chunk.end - chunk.begin);
+        try {
+            chunkRecords[chunkIndex] = parse_ndjson_records(text);
+        }
+        catch (const std::exception &exc) {
+            throw std::runtime_error(ndjsonDatabaseFiles[chunk.fileIndex].second + ": " + exc.what());
+        }
+        chunkEnds[chunkIndex] = Clock::now();
+    });
+
+    ingestion.statistics = json::object();
+    for (size_t fileIndex = 0; fileIndex < ndjsonDatabaseFiles.size(); ++fileIndex) {
+        auto& [section, fileName] = ndjsonDatabaseFiles[fileIndex];
+        ingestion.data[section] = json();
+
+        size_t numberRecords = 0;
+        size_t numberChunks = 0;
+        double cpuSeconds = 0;
+        std::optional<Clock::time_point> firstStart;
+        std::optional<Clock::time_point> lastEnd;
+        for (size_t chunkIndex = 0; chunkIndex < chunks.size(); ++chunkIndex) {
+            if (chunks[chunkIndex].fileIndex != fileIndex) {
+                continue;
+            }
+            for (auto& record : chunkRecords[chunkIndex]) {
+                auto name = add_loaded_record(ingestion.files[fileIndex], record);
+                ingestion.data[section][name] = std::move(record.document);
+                numberRecords++;
+            }
+            numberChunks++;
+            cpuSeconds += std::chrono::duration<double>(chunkEnds[chunkIndex] - chunkStarts[chunkIndex]).count();
+            if (!firstStart || chunkStarts[chunkIndex] < *firstStart) {
+                firstStart = chunkStarts[chunkIndex];
+            }
+            if (!lastEnd || chunkEnds[chunkIndex] > *lastEnd) {
+                lastEnd = chunkEnds[chunkIndex];
+            }
+        }
+
+        json fileStatistics;
+        fileStatistics["found"] = files[fileIndex].has_value();
+        fileStatistics["bytes"] = files[fileIndex] ? files[fileIndex]->size() : 0;
+        fileStatistics["records"] = numberRecords;
+        fileStatistics["chunks"] = numberChunks;
+        fileStatistics["parseSeconds"] = firstStart ? std::chrono::duration<double>(*lastEnd - *firstStart).count() : 0.0;
+        fileStatistics["cpuSeconds"] = cpuSeconds;
+        ingestion.statistics[fileName] = fileStatistics;
+    }
+    return ingestion;
+}
+
+// One change to a database: the record to put under key, or nullopt to remove key
+struct ReloadOperation {
+    std::string key;
+    std::optional<DatabaseRecord> record;
+};
+
+struct ParsedDatabaseFile {
+    LoadedFile loaded;
+    std::vector<NdjsonRecord> records;
+    // Filled by plan_reload, in the order they are applied
+    std::vector<ReloadOperation> operations;
+    size_t added = 0;
+    size_t updated = 0;
+    size_t removed = 0;
+};
+
+// Parses a single database file in line-aligned chunks on the worker threads
+ParsedDatabaseFile parse_database_file(const std::filesystem::path& filePath) {
+    ParsedDatabaseFile parsed;
+    parsed.loaded.modificationTime = std::filesystem::last_write_time(filePath);
+    MappedFile file(filePath);
+    parsed.loaded.found = true;
+    parsed.loaded.size = file.size();
+
+    auto chunks = split_ndjson_lines(file.view(), std::max(minimumNdjsonChunkSize, file.size() / (get_number_threads() * 4) + 1));
+    std::vector<std::vector<NdjsonRecord>> chunkRecords(chunks.size());
+    parallel_for(chunks.size(), [&](size_t chunkIndex) {
+        auto [begin, end] = chunks[chunkIndex];
+        try {
+            chunkRecords[chunkIndex] = parse_ndjson_records(file.view().substr(begin, end - begin));
+        }
+        catch (const std::exception &exc) {
+            throw std::runtime_error(filePath.filename().string() + ": " + exc.what());
+        }
+    });
+    for (auto& records : chunkRecords) {
+        for (auto& record : records) {
+            add_loaded_record(parsed.loaded, record);
+            parsed.records.push_back(std::move(record));
+        }
+    }
+    return parsed;
+}
+
+// Diffs a changed file by name against what was loaded from it before and builds every added and
+// updated record, with its aliases, so a schema-invalid record fails here rather than halfway through applying
+void plan_reload(size_t fileIndex, const LoadedFile& loaded, ParsedDatabaseFile& parsed) {
+    auto& previous = loaded.records;
+    auto& current = parsed.loaded.records;
+    for (auto& record : parsed.records) {
+        std::string name = record.document["name"];
+        auto& currentRecord = current.at(name);
+        // A name repeated in the file keeps its last line, as in a full load
+        if (currentRecord.lineHash != record.lineHash) {
+            continue;
+        }
+        auto previousRecord = previous.find(name);
+        if (previousRecord != previous.end() && previousRecord->second.lineHash == record.lineHash) {
+            continue;
+        }
+        if (previousRecord == previous.end()) {
+            parsed.added++;
+        }
+        else {
+            parsed.updated++;
+            for (auto& alias : previousRecord->second.aliases) {
+                if (std::find(currentRecord.aliases.begin(), currentRecord.aliases.end(), alias) == currentRecord.aliases.end()) {
+                    parsed.operations.push_back({std::string(alias), std::nullopt});
+                }
+            }
+        }
+        try {
+            parsed.operations.push_back({name, build_database_record(fileIndex, record.document)});
+            for (auto& alias : currentRecord.aliases) {
+                auto aliasDocument = record.document;
+                aliasDocument["name"] = std::string(alias);
+                parsed.operations.push_back({std::string(alias), build_database_record(fileIndex, aliasDocument)});
+            }
+        }
+        catch (const std::exception &exc) {
+            throw std::runtime_error(ndjsonDatabaseFiles[fileIndex].second + ": " + name + ": " + exc.what());
+        }
+    }
+    for (auto& [name, previousRecord] : previous) {
+        if (current.contains(name)) {
+            continue;
+        }
+        parsed.removed++;
+        parsed.operations.push_back({std::string(name), std::nullopt});
+        for (auto& alias : previousRecord.aliases) {
+            parsed.operations.push_back({std::string(alias), std::nullopt});
+        }
+    }
+    // Documents are no longer needed once their records are built
+    parsed.records.clear();
+}
+
+// Eager loads go on top of everything a lazy load indexed, so pending records are materialized first
+void leave_lazy_loading() {
+    materialize_all_records();
+    disable_lazy_loading();
+}
+
+} // namespace
+
+uint64_t get_database_version() {
+    return databaseVersion.load(std::memory_order_acquire);
+}
+
+uint64_t get_database_fingerprint() {
+    return databaseFingerprint.load(std::memory_order_acquire);
+}
+
+void load_databases(json databasesJson, bool lazy) {
+    set_database_fingerprint(databasesJson.empty() ? 0 : hash_text(databasesJson.dump()));
+    if (lazy) {
+        enable_lazy_loading_from_json(databasesJson, true);
+        reset_reload_baseline();
+        bump_database_version();
+        return;
+    }
+    disable_lazy_loading();
     OpenMagnetics::load_databases(databasesJson, true);
+    reset_reload_baseline();
+    bump_database_version();
 }
 
-std::string read_databases(std::string path, bool addInternalData) {
+std::string read_databases(std::string path, bool addInternalData, bool lazy) {
     try {
+        if (lazy) {
+            set_database_fingerprint(enable_lazy_loading_from_path(path, addInternalData));
+            reset_reload_baseline();
+            bump_database_version();
+            return "0";
+        }
+        disable_lazy_loading();
         auto masPath = std::filesystem::path{path};
-        json data;
-        std::string line;
-        {
-            data["coreMaterials"] = json();
-            std::ifstream coreMaterials(masPath.append("core_materials.ndjson"));
-            while (getline (coreMaterials, line)) {
-                json jf = json::parse(line);
-                data["coreMaterials"][jf["name"]] = jf;
+        auto ingestion = ingest_ndjson_databases(masPath);
+        OpenMagnetics::load_databases(ingestion.data, true, addInternalData);
+        bump_database_version();
+        lastIngestionStatistics = ingestion.statistics;
+        loadedDatabasesPath = masPath;
+        loadedFiles = std::move(ingestion.files);
+        set_database_fingerprint(hash_loaded_files(hash_text(addInternalData ? "internal" : "")));
+        return "0";
+    }
+    catch (const std::exception &exc) {
+        return std::string{exc.what()};
+    }
+}
+
+json get_database_ingestion_statistics() {
+    return lastIngestionStatistics;
+}
+
+// Only files whose modification time or size changed are read, and of those only files whose
+// records hash differently are applied. Records are then diffed by name against what was loaded
+// before, and only added, updated and removed records, with their aliases, touch the databases.
+json reload_databases(std::string path) {
+    try {
+        leave_lazy_loading();
+        auto masPath = std::filesystem::path{path};
+        if (masPath != loadedDatabasesPath) {
+            // Without a baseline for this folder every record counts as added and none as removed
+            reset_reload_baseline();
+        }
+
+        // Parse and build everything that changed before applying anything, so a broken file or an
+        // invalid record leaves the databases untouched
+        std::vector<std::optional<ParsedDatabaseFile>> changedFiles(ndjsonDatabaseFiles.size());
+        for (size_t fileIndex = 0; fileIndex < ndjsonDatabaseFiles.size(); ++fileIndex) {
+            auto filePath = masPath / ndjsonDatabaseFiles[fileIndex].second;
+            auto& loaded = loadedFiles[fileIndex];
+            if (!std::filesystem::exists(filePath)) {
+                if (loaded.found) {
+                    changedFiles[fileIndex].emplace();
+                    plan_reload(fileIndex, loaded, changedFiles[fileIndex].value());
+                }
+                continue;
+            }
+            if (loaded.found && loaded.modificationTime == std::filesystem::last_write_time(filePath) && loaded.size == std::filesystem::file_size(filePath)) {
+                continue;
             }
+            auto parsed = parse_database_file(filePath);
+            if (loaded.found && parsed.loaded.hash == loaded.hash) {
+                // Touched but not changed
+                loaded.modificationTime = parsed.loaded.modificationTime;
+                continue;
+            }
+            plan_reload(fileIndex, loaded, parsed);
+            changedFiles[fileIndex] = std::move(parsed);
         }
-        {
-            data["coreShapes"] = json();
-            std::ifstream coreMaterials(masPath.append("core_shapes.ndjson"));
-            while (getline (coreMaterials, line)) {
-                json jf = json::parse(line);
-                data["coreShapes"][jf["name"]] = jf;
+
+        json report = json::object();
+        bool coresChanged = false;
+        bool anyChanged = false;
+        try {
+            for (size_t fileIndex = 0; fileIndex < ndjsonDatabaseFiles.size(); ++fileIndex) {
+                auto& fileName = ndjsonDatabaseFiles[fileIndex].second;
+                json fileReport;
+                fileReport["changed"] = changedFiles[fileIndex].has_value();
+                fileReport["added"] = 0;
+                fileReport["updated"] = 0;
+                fileReport["removed"] = 0;
+                if (!changedFiles[fileIndex]) {
+                    report[fileName] = fileReport;
+                    continue;
+                }
+
+                auto& changedFile = changedFiles[fileIndex].value();
+                auto& section = ndjsonDatabaseFiles[fileIndex].first;
+                for (auto& operation : changedFile.operations) {
+                    anyChanged = true;
+                    coresChanged = coresChanged || section == "coreMaterials" || section == "coreShapes";
+                    if (operation.record) {
+                        insert_database_record(operation.key, std::move(operation.record.value()));
+                    }
+                    else {
+                        erase_database_record(fileIndex, operation.key);
+                    }
+                }
+
+                fileReport["added"] = changedFile.added;
+                fileReport["updated"] = changedFile.updated;
+                fileReport["removed"] = changedFile.removed;
+                report[fileName] = fileReport;
+                loadedFiles[fileIndex] = std::move(changedFile.loaded);
             }
         }
-        {
-            data["wires"] = json();
-            std::ifstream coreMaterials(masPath.append("wires.ndjson"));
-            while (getline (coreMaterials, line)) {
-                json jf = json::parse(line);
-                data["wires"][jf["name"]] = jf;
+        catch (...) {
+            // Whatever was applied before the failure stays, so everything derived from the databases is invalidated
+            if (coresChanged) {
+                OpenMagnetics::coreDatabase.clear();
+            }
+            if (anyChanged) {
+                set_database_fingerprint(hash_loaded_files(get_database_fingerprint()));
+                bump_database_version();
             }
+            throw;
+        }
+        loadedDatabasesPath = masPath;
+
+        if (coresChanged) {
+            // Cores are built from materials and shapes, they are rebuilt on next use
+            OpenMagnetics::coreDatabase.clear();
+        }
+        if (anyChanged) {
+            set_database_fingerprint(hash_loaded_files(get_database_fingerprint()));
+            bump_database_version();
+        }
+        return report;
+    }
+    catch (const std::exception &exc) {
+        json exception;
+        exception["data"] = "Exception: " + std::string{exc.what()};
+        return exception;
+    }
+}
+
+std::string save_database_snapshot(std::string path) {
+    try {
+        // Records a lazy load has not built yet belong in the snapshot too
+        materialize_all_records();
+        std::string buffer(sizeof(SnapshotHeader), '\0');
+        align_buffer(buffer);
+        uint64_t sectionTableOffset = buffer.size();
+        buffer.resize(buffer.size() + snapshotNumberSections * sizeof(SnapshotSection), '\0');
+
+        std::vector<SnapshotSection> sections;
+        sections.push_back(write_snapshot_section(buffer, "coreMaterials", OpenMagnetics::coreMaterialDatabase));
+        sections.push_back(write_snapshot_section(buffer, "coreShapes", OpenMagnetics::coreShapeDatabase));
+        sections.push_back(write_snapshot_section(buffer, "wires", OpenMagnetics::wireDatabase));
+        sections.push_back(write_snapshot_section(buffer, "bobbins", OpenMagnetics::bobbinDatabase));
+        sections.push_back(write_snapshot_section(buffer, "insulationMaterials", OpenMagnetics::insulationMaterialDatabase));
+        sections.push_back(write_snapshot_section(buffer, "wireMaterials", OpenMagnetics::wireMaterialDatabase));
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+        header.schemaVersion = snapshotSchemaVersion;
+        header.byteOrderMark = snapshotByteOrderMark;
+        std::strncpy(header.masRevision, MACRO_STRINGIFY(MAS_REVISION), sizeof(header.masRevision) - 1);
+        header.numberSections = sections.size();
+        header.sectionTableOffset = sectionTableOffset;
+        header.databaseFingerprint = get_database_fingerprint();
+        write_at(buffer, 0, header);
+        for (size_t sectionIndex = 0; sectionIndex < sections.size(); ++sectionIndex) {
+            write_at(buffer, sectionTableOffset + sectionIndex * sizeof(SnapshotSection), sections[sectionIndex]);
         }
+
+        // Write next to the destination and rename, so workers never map a half-written snapshot
+        auto snapshotPath = std::filesystem::path{path};
+        auto temporaryPath = snapshotPath;
+        temporaryPath += ".tmp";
         {
-            data["bobbins"] = json();
-            std::ifstream coreMaterials(masPath.append("bobbins.ndjson"));
-            while (getline (coreMaterials, line)) {
-                json jf = json::parse(line);
-                data["bobbins"][jf["name"]] = jf;
+            std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Cannot open " + temporaryPath.string() + " for writing");
+            }
+            out.write(buffer.data(), buffer.size());
+            if (!out) {
+                throw std::runtime_error("Cannot write snapshot to " + temporaryPath.string());
             }
         }
-        {
-            data["insulationMaterials"] = json();
-            std::ifstream coreMaterials(masPath.append("insulation_materials.ndjson"));
-            while (getline (coreMaterials, line)) {
-                json jf = json::parse(line);
-                data["insulationMaterials"][jf["name"]] = jf;
+        std::filesystem::rename(temporaryPath, snapshotPath);
+        return "0";
+    }
+    catch (const std::exception &exc) {
+        return std::string{exc.what()};
+    }
+}
+
+std::string load_database_snapshot(std::string path, bool lazy) {
+    try {
+        auto mappedFile = std::make_shared<const MappedFile>(path);
+        auto& file = *mappedFile;
+        auto header = read_at<SnapshotHeader>(file, 0);
+        if (std::memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0) {
+            throw std::runtime_error(path + " is not a database snapshot");
+        }
+        if (header.byteOrderMark != snapshotByteOrderMark) {
+            throw std::runtime_error("Snapshot was written on a machine with different byte order");
+        }
+        if (header.schemaVersion != snapshotSchemaVersion) {
+            throw std::runtime_error("Snapshot schema version " + std::to_string(header.schemaVersion) + " does not match expected version " + std::to_string(snapshotSchemaVersion));
+        }
+        std::string snapshotMasRevision(header.masRevision, strnlen(header.masRevision, sizeof(header.masRevision)));
+        if (snapshotMasRevision != MACRO_STRINGIFY(MAS_REVISION)) {
+            throw std::runtime_error("Snapshot MAS revision " + snapshotMasRevision + " does not match built MAS revision " + MACRO_STRINGIFY(MAS_REVISION));
+        }
+
+        std::map<std::string, SnapshotRecordViews> sections;
+        for (uint64_t sectionIndex = 0; sectionIndex < header.numberSections; ++sectionIndex) {
+            auto section = read_at<SnapshotSection>(file, header.sectionTableOffset + sectionIndex * sizeof(SnapshotSection));
+            std::string sectionName(section.name, strnlen(section.name, sizeof(section.name)));
+            if (std::none_of(ndjsonDatabaseFiles.begin(), ndjsonDatabaseFiles.end(), [&](auto& databaseFile) { return databaseFile.first == sectionName; })) {
+                throw std::runtime_error("Unknown snapshot section: " + sectionName);
             }
+            sections[sectionName] = read_snapshot_record_views(file, section);
         }
-        {
-            data["wireMaterials"] = json();
-            std::ifstream coreMaterials(masPath.append("wire_materials.ndjson"));
-            while (getline (coreMaterials, line)) {
-                json jf = json::parse(line);
-                data["wireMaterials"][jf["name"]] = jf;
+
+        if (lazy) {
+            // Only the record tables are read, each record is decoded the first time it is looked up,
+            // so a record that does not decode fails that lookup instead of the load
+            enable_lazy_loading_from_snapshot(mappedFile, sections);
+            OpenMagnetics::coreDatabase.clear();
+            set_database_fingerprint(header.databaseFingerprint);
+            reset_reload_baseline();
+            bump_database_version();
+            return "0";
+        }
+
+        // Decode everything before touching the live databases, so a bad snapshot leaves them untouched
+        decltype(OpenMagnetics::coreMaterialDatabase) coreMaterials;
+        decltype(OpenMagnetics::coreShapeDatabase) coreShapes;
+        decltype(OpenMagnetics::wireDatabase) wires;
+        decltype(OpenMagnetics::bobbinDatabase) bobbins;
+        decltype(OpenMagnetics::insulationMaterialDatabase) insulationMaterials;
+        decltype(OpenMagnetics::wireMaterialDatabase) wireMaterials;
+        for (auto& [sectionName, records] : sections) {
+            if (sectionName == "coreMaterials") {
+                coreMaterials = read_snapshot_section<decltype(coreMaterials)>(records);
+            }
+            else if (sectionName == "coreShapes") {
+                coreShapes = read_snapshot_section<decltype(coreShapes)>(records);
+            }
+            else if (sectionName == "wires") {
+                wires = read_snapshot_section<decltype(wires)>(records);
+            }
+            else if (sectionName == "bobbins") {
+                bobbins = read_snapshot_section<decltype(bobbins)>(records);
+            }
+            else if (sectionName == "insulationMaterials") {
+                insulationMaterials = read_snapshot_section<decltype(insulationMaterials)>(records);
+            }
+            else if (sectionName == "wireMaterials") {
+                wireMaterials = read_snapshot_section<decltype(wireMaterials)>(records);
             }
         }
-        OpenMagnetics::load_databases(data, true, addInternalData);
+
+        disable_lazy_loading();
+        OpenMagnetics::coreMaterialDatabase = std::move(coreMaterials);
+        OpenMagnetics::coreShapeDatabase = std::move(coreShapes);
+        OpenMagnetics::wireDatabase = std::move(wires);
+        OpenMagnetics::bobbinDatabase = std::move(bobbins);
+        OpenMagnetics::insulationMaterialDatabase = std::move(insulationMaterials);
+        OpenMagnetics::wireMaterialDatabase = std::move(wireMaterials);
+        // Cores were built from the replaced materials and shapes, they are rebuilt on next use
+        OpenMagnetics::coreDatabase.clear();
+        set_database_fingerprint(header.databaseFingerprint);
+        reset_reload_baseline();
+        bump_database_version();
         return "0";
     }
     catch (const std::exception &exc) {
@@ -72,13 +716,13 @@ std::string read_databases(std::string path, bool addInternalData) {
 
 std::string load_mas(std::string key, json masJson, bool expand) {
     try {
+        materialize_references(masJson);
         OpenMagnetics::Mas mas(masJson);
         if (expand) {
-            mas.set_magnetic(OpenMagnetics::magnetic_autocomplete(mas.get_mutable_magnetic()));
+            mas.set_magnetic(autocomplete_magnetic(mas.get_mutable_magnetic()));
             mas.set_inputs(OpenMagnetics::inputs_autocomplete(mas.get_mutable_inputs(), mas.get_mutable_magnetic()));
         }
-        masDatabase[key] = mas;
-        return std::to_string(masDatabase.size());
+        return std::to_string(masDatabase.insert(key, std::move(mas)));
     }
     catch (const std::exception &exc) {
         return std::string{exc.what()};
@@ -87,14 +731,14 @@ std::string load_mas(std::string key, json masJson, bool expand) {
 
 std::string load_magnetic(std::string key, json magneticJson, bool expand) {
     try {
+        materialize_references(magneticJson);
         OpenMagnetics::Magnetic magnetic(magneticJson);
         if (expand) {
-            magnetic = OpenMagnetics::magnetic_autocomplete(magnetic);
+            magnetic = autocomplete_magnetic(magnetic);
         }
         OpenMagnetics::Mas mas;
         mas.set_magnetic(magnetic);
-        masDatabase[key] = mas;
-        return std::to_string(masDatabase.size());
+        return std::to_string(masDatabase.insert(key, std::move(mas)));
     }
     catch (const std::exception &exc) {
         return std::string{exc.what()};
@@ -104,14 +748,15 @@ std::string load_magnetic(std::string key, json magneticJson, bool expand) {
 std::string load_magnetics(std::string keys, json magneticJsons, bool expand) {
     try {
         json keysJson = json::parse(keys);
+        materialize_references(magneticJsons);
         for (size_t magneticIndex = 0; magneticIndex < magneticJsons.size(); magneticIndex++) {
             OpenMagnetics::Magnetic magnetic(magneticJsons[magneticIndex]);
             if (expand) {
-                magnetic = OpenMagnetics::magnetic_autocomplete(magnetic);
+                magnetic = autocomplete_magnetic(magnetic);
             }
             OpenMagnetics::Mas mas;
             mas.set_magnetic(magnetic);
-            masDatabase[to_string(keysJson[magneticIndex])] = mas;
+            masDatabase.insert(to_string(keysJson[magneticIndex]), std::move(mas));
         }
         return std::to_string(masDatabase.size());
     }
@@ -120,73 +765,382 @@ std::string load_magnetics(std::string keys, json magneticJsons, bool expand) {
     }
 }
 
+// Magnetics are built and autocompleted on the worker threads, then inserted in one pass.
+// Each item reports "0" or the error that stopped it, so one bad design does not abort the batch.
+// Databases are completed while the GIL is still held, so the workers only read them and no other
+// Python thread sees them change while they run.
+std::vector<std::string> load_magnetics_batch(std::vector<std::string> keys, std::vector<json> magneticJsons, bool expand) {
+    if (keys.size() != magneticJsons.size()) {
+        return std::vector<std::string>(magneticJsons.size(), "Number of keys does not match number of magnetics");
+    }
+    try {
+        ensure_databases_loaded();
+    }
+    catch (const std::exception &exc) {
+        return std::vector<std::string>(magneticJsons.size(), std::string{exc.what()});
+    }
+
+    py::gil_scoped_release release;
+    std::vector<std::optional<OpenMagnetics::Mas>> masses(magneticJsons.size());
+    std::vector<std::string> status(magneticJsons.size(), "0");
+    parallel_for(magneticJsons.size(), [&](size_t magneticIndex) {
+        try {
+            OpenMagnetics::Magnetic magnetic(magneticJsons[magneticIndex]);
+            if (expand) {
+                magnetic = autocomplete_magnetic(magnetic);
+            }
+            OpenMagnetics::Mas mas;
+            mas.set_magnetic(magnetic);
+            masses[magneticIndex] = std::move(mas);
+        }
+        catch (const std::exception &exc) {
+            status[magneticIndex] = std::string{exc.what()};
+        }
+    });
+
+    std::vector<std::pair<std::string, OpenMagnetics::Mas>> items;
+    items.reserve(magneticJsons.size());
+    for (size_t magneticIndex = 0; magneticIndex < magneticJsons.size(); ++magneticIndex) {
+        if (masses[magneticIndex]) {
+            items.emplace_back(keys[magneticIndex], std::move(masses[magneticIndex].value()));
+        }
+    }
+    masDatabase.insert_many(std::move(items));
+    return status;
+}
+
 json read_mas(std::string key) {
+    auto mas = masDatabase.find(key);
     json result;
-    to_json(result, masDatabase[key]);
+    if (!mas) {
+        result["errorMessage"] = "MAS not found: " + key;
+        return result;
+    }
+    to_json(result, *mas);
     return result;
 }
 
+void set_mas_memory_budget(size_t memoryBudget) {
+    masDatabase.set_memory_budget(memoryBudget);
+}
+
+json get_mas_statistics() {
+    return masDatabase.get_statistics();
+}
+
+void clear_mas() {
+    masDatabase.clear();
+}
+
 size_t load_core_materials(std::string fileToLoad) {
+    leave_lazy_loading();
     if (fileToLoad != "") {
         OpenMagnetics::load_core_materials(fileToLoad);
     }
     else {
         OpenMagnetics::load_core_materials();
     }
+    mix_database_fingerprint("coreMaterials\n" + (fileToLoad != "" ? hash_file(fileToLoad) : std::string{"default"}));
+    bump_database_version();
     return OpenMagnetics::coreMaterialDatabase.size();
 }
 
 size_t load_core_shapes(std::string fileToLoad) {
+    leave_lazy_loading();
     if (fileToLoad != "") {
         OpenMagnetics::load_core_shapes(true, fileToLoad);
     }
     else {
         OpenMagnetics::load_core_shapes();
     }
+    mix_database_fingerprint("coreShapes\n" + (fileToLoad != "" ? hash_file(fileToLoad) : std::string{"default"}));
+    bump_database_version();
     return OpenMagnetics::coreShapeDatabase.size();
 }
 
 size_t load_wires(std::string fileToLoad) {
+    leave_lazy_loading();
     if (fileToLoad != "") {
         OpenMagnetics::load_wires(fileToLoad);
     }
     else {
         OpenMagnetics::load_wires();
     }
+    mix_database_fingerprint("wires\n" + (fileToLoad != "" ? hash_file(fileToLoad) : std::string{"default"}));
+    bump_database_version();
     return OpenMagnetics::wireDatabase.size();
 }
 
 void clear_databases() {
+    disable_lazy_loading();
     OpenMagnetics::clear_databases();
+    set_database_fingerprint(0);
+    reset_reload_baseline();
+    bump_database_version();
+}
+
+void ensure_core_databases_loaded() {
+    if (OpenMagnetics::coreMaterialDatabase.empty()) {
+        OpenMagnetics::load_core_materials();
+    }
+    if (OpenMagnetics::coreShapeDatabase.empty()) {
+        OpenMagnetics::load_core_shapes();
+    }
+}
+
+void ensure_databases_loaded() {
+    materialize_all_records();
+    ensure_core_databases_loaded();
+    if (OpenMagnetics::wireDatabase.empty()) {
+        OpenMagnetics::load_wires();
+    }
+    if (OpenMagnetics::bobbinDatabase.empty()) {
+        OpenMagnetics::load_bobbins();
+    }
+    if (OpenMagnetics::insulationMaterialDatabase.empty()) {
+        OpenMagnetics::load_insulation_materials();
+    }
+    if (OpenMagnetics::wireMaterialDatabase.empty()) {
+        OpenMagnetics::load_wire_materials();
+    }
 }
 
 bool is_core_material_database_empty() {
-    return OpenMagnetics::coreMaterialDatabase.size() == 0;
+    return OpenMagnetics::coreMaterialDatabase.size() == 0 && count_lazy_records("coreMaterials") == 0;
 }
 
 bool is_core_shape_database_empty() {
-    return OpenMagnetics::coreShapeDatabase.size() == 0;
+    return OpenMagnetics::coreShapeDatabase.size() == 0 && count_lazy_records("coreShapes") == 0;
 }
 
 bool is_wire_database_empty() {
-    return OpenMagnetics::wireDatabase.size() == 0;
+    return OpenMagnetics::wireDatabase.size() == 0 && count_lazy_records("wires") == 0;
 }
 
-std::string load_magnetics_from_file(std::string path, bool expand) {
+namespace {
+
+struct MagneticsFileLine {
+    size_t lineNumber;
+    std::string text;
+};
+
+struct MagneticsFileItem {
+    size_t lineNumber;
+    std::string key;
+    std::optional<OpenMagnetics::Magnetic> magnetic;
+    std::string error;
+};
+
+// Lines in flight per pipeline stage, bounding memory whatever the size of the file
+constexpr size_t magneticsFileQueueCapacity = 256;
+// Skipped lines listed individually in the report, the rest are only counted
+constexpr size_t magneticsFileMaximumReportedErrors = 1000;
+constexpr double magneticsFileProgressSeconds = 0.2;
+
+json lastMagneticsFileLoadReport = json::object();
+
+// Stage threads of load_magnetics_from_file. However the load is left, including a failed thread
+// start, the queues are closed so every stage winds down, and the threads are joined.
+class MagneticsFilePipeline {
+  public:
+    MagneticsFilePipeline(BoundedQueue<MagneticsFileLine>& lines, BoundedQueue<MagneticsFileItem>& parsed, BoundedQueue<MagneticsFileItem>& completed)
+        : _lines(lines), _parsed(parsed), _completed(completed) {}
+    MagneticsFilePipeline(const MagneticsFilePipeline&) = delete;
+    MagneticsFilePipeline& operator=(const MagneticsFilePipeline&) = delete;
+
+    ~MagneticsFilePipeline() {
+        stop();
+    }
+
+    template <typename Stage>
+    void start(Stage&& stage) {
+        _threads.emplace_back(std::forward<Stage>(stage));
+    }
+
+    void stop() {
+        _lines.close();
+        _parsed.close();
+        _completed.close();
+        for (auto& thread : _threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        _threads.clear();
+    }
+
+  private:
+    BoundedQueue<MagneticsFileLine>& _lines;
+    BoundedQueue<MagneticsFileItem>& _parsed;
+    BoundedQueue<MagneticsFileItem>& _completed;
+    std::vector<std::thread> _threads;
+};
+
+} // namespace
+
+// Reader, parser pool, autocomplete pool and cache inserter run concurrently, connected by bounded
+// queues. The inserter is the calling thread, which also reports progress. When a key appears on
+// several lines the last one wins, as in a sequential load, whatever order the lines finish in.
+std::string load_magnetics_from_file(std::string path, bool expand, std::optional<py::function> progress) {
     try {
         std::ifstream in(path);
-        if (in) {
-            std::string line;
-            while (getline(in, line)) {
-                json jf = json::parse(line);
-                OpenMagnetics::Magnetic magnetic(jf);
-                if (expand) {
-                    magnetic = OpenMagnetics::magnetic_autocomplete(magnetic);
+        if (!in) {
+            return std::to_string(OpenMagnetics::magneticsCache.size());
+        }
+        // Parsers resolve names too, so the databases are completed whether or not lines are expanded,
+        // and before the GIL is released so no other Python thread sees them change
+        ensure_databases_loaded();
+        py::gil_scoped_release release;
+
+        auto start = std::chrono::steady_clock::now();
+        size_t numberThreads = get_number_threads();
+        size_t numberParsers = std::max<size_t>(1, numberThreads / 4);
+        size_t numberAutocompleters = expand ? std::max<size_t>(1, numberThreads - numberParsers) : 1;
+
+        BoundedQueue<MagneticsFileLine> lines(magneticsFileQueueCapacity);
+        BoundedQueue<MagneticsFileItem> parsed(magneticsFileQueueCapacity);
+        BoundedQueue<MagneticsFileItem> completed(magneticsFileQueueCapacity);
+        std::atomic<size_t> activeParsers{numberParsers};
+        std::atomic<size_t> activeAutocompleters{numberAutocompleters};
+        std::atomic<size_t> numberLines{0};
+        std::string readError;
+
+        MagneticsFilePipeline pipeline(lines, parsed, completed);
+        pipeline.start([&]() {
+            try {
+                std::string line;
+                size_t lineNumber = 0;
+                while (getline(in, line)) {
+                    ++lineNumber;
+                    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                        continue;
+                    }
+                    numberLines.fetch_add(1, std::memory_order_relaxed);
+                    if (!lines.push({lineNumber, std::move(line)})) {
+                        break;
+                    }
+                }
+            }
+            catch (const std::exception &exc) {
+                readError = exc.what();
+            }
+            lines.close();
+        });
+        for (size_t parserIndex = 0; parserIndex < numberParsers; ++parserIndex) {
+            pipeline.start([&]() {
+                while (auto line = lines.pop()) {
+                    MagneticsFileItem item{line->lineNumber, "", std::nullopt, ""};
+                    try {
+                        OpenMagnetics::Magnetic magnetic(json::parse(line->text));
+                        if (!magnetic.get_manufacturer_info() || !magnetic.get_manufacturer_info()->get_reference()) {
+                            throw std::runtime_error("Magnetic is missing its manufacturer reference");
+                        }
+                        item.key = magnetic.get_manufacturer_info()->get_reference().value();
+                        item.magnetic = std::move(magnetic);
+                    }
+                    catch (const std::exception &exc) {
+                        item.error = exc.what();
+                    }
+                    if (!parsed.push(std::move(item))) {
+                        break;
+                    }
+                }
+                if (activeParsers.fetch_sub(1) == 1) {
+                    parsed.close();
+                }
+            });
+        }
+        for (size_t autocompleterIndex = 0; autocompleterIndex < numberAutocompleters; ++autocompleterIndex) {
+            pipeline.start([&]() {
+                while (auto item = parsed.pop()) {
+                    if (expand && item->magnetic) {
+                        try {
+                            item->magnetic = autocomplete_magnetic(item->magnetic.value());
+                        }
+                        catch (const std::exception &exc) {
+                            item->magnetic = std::nullopt;
+                            item->error = exc.what();
+                        }
+                    }
+                    if (!completed.push(std::move(item.value()))) {
+                        break;
+                    }
+                }
+                if (activeAutocompleters.fetch_sub(1) == 1) {
+                    completed.close();
+                }
+            });
+        }
+
+        json errors = json::array();
+        size_t numberLoaded = 0;
+        size_t numberSkipped = 0;
+        std::string callbackError;
+        std::unordered_map<std::string, size_t> lineByKey;
+        auto lastProgress = std::chrono::steady_clock::now();
+        auto report_progress = [&]() {
+            py::gil_scoped_acquire acquire;
+            try {
+                (*progress)(numberLoaded + numberSkipped, numberLoaded, numberSkipped);
+            }
+            catch (const std::exception &exc) {
+                callbackError = exc.what();
+            }
+        };
+
+        while (auto item = completed.pop()) {
+            if (item->magnetic) {
+                auto [it, inserted] = lineByKey.try_emplace(item->key, item->lineNumber);
+                if (inserted || it->second < item->lineNumber) {
+                    it->second = item->lineNumber;
+                    try {
+                        OpenMagnetics::magneticsCache.load(item->key, item->magnetic.value());
+                    }
+                    catch (const std::exception &exc) {
+                        item->error = exc.what();
+                    }
+                }
+            }
+            if (item->error.empty()) {
+                ++numberLoaded;
+            }
+            else {
+                ++numberSkipped;
+                if (errors.size() < magneticsFileMaximumReportedErrors) {
+                    errors.push_back({{"line", item->lineNumber}, {"message", item->error}});
+                }
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (progress && std::chrono::duration<double>(now - lastProgress).count() >= magneticsFileProgressSeconds) {
+                lastProgress = now;
+                report_progress();
+                if (!callbackError.empty()) {
+                    break;
                 }
-                std::string key = magnetic.get_manufacturer_info()->get_reference().value();
-                OpenMagnetics::magneticsCache.load(key, magnetic);
             }
         }
+
+        // On an early stop every stage sees its queues closed and winds down
+        pipeline.stop();
+        if (progress && callbackError.empty()) {
+            report_progress();
+        }
+
+        json report;
+        report["lines"] = numberLines.load();
+        report["loaded"] = numberLoaded;
+        report["skipped"] = numberSkipped;
+        report["errors"] = errors;
+        report["seconds"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        lastMagneticsFileLoadReport = report;
+
+        if (!readError.empty()) {
+            return readError;
+        }
+        if (!callbackError.empty()) {
+            return callbackError;
+        }
         return std::to_string(OpenMagnetics::magneticsCache.size());
     }
     catch (const std::exception &exc) {
@@ -194,6 +1148,10 @@ std::string load_magnetics_from_file(std::string path, bool expand) {
     }
 }
 
+json get_magnetics_file_load_report() {
+    return lastMagneticsFileLoadReport;
+}
+
 std::string clear_magnetic_cache() {
     try {
         OpenMagnetics::magneticsCache.clear();
@@ -205,12 +1163,38 @@ std::string clear_magnetic_cache() {
 }
 
 void register_database_bindings(py::module& m) {
-    m.def("load_databases", &load_databases, "Load all databases from JSON");
-    m.def("read_databases", &read_databases, "Read databases from file path");
+    m.def("load_databases", &load_databases,
+        "Load all databases from JSON. With lazy=True only a name index is built and records are materialized on first use",
+        py::arg("databases"), py::arg("lazy") = false);
+    m.def("read_databases", &read_databases,
+        "Read databases from file path. With lazy=True the ndjson files are copied into memory and indexed instead of parsed",
+        py::arg("path"), py::arg("add_internal_data"), py::arg("lazy") = false);
+    m.def("get_lazy_loading_statistics", &get_lazy_loading_statistics,
+        "Number of indexed and materialized records per database when loaded lazily");
+    m.def("reload_databases", &reload_databases,
+        "Apply changes to the ndjson files of a folder loaded with read_databases, touching only added, updated and removed records",
+        py::arg("path"));
+    m.def("get_database_ingestion_statistics", &get_database_ingestion_statistics,
+        "Per-file record counts and parse timings of the last read_databases call");
+    m.def("save_database_snapshot", &save_database_snapshot,
+        "Write the loaded core material, shape, wire, bobbin and insulation databases to a binary snapshot",
+        py::arg("path"));
+    m.def("load_database_snapshot", &load_database_snapshot,
+        "Load databases from a binary snapshot, refusing snapshots from another schema version or MAS revision. With lazy=True the snapshot stays mapped and each record is decoded on first use",
+        py::arg("path"), py::arg("lazy") = true);
     m.def("load_mas", &load_mas, "Load a MAS (Magnetic Agnostic Structure) object");
     m.def("load_magnetic", &load_magnetic, "Load a magnetic component");
     m.def("load_magnetics", &load_magnetics, "Load multiple magnetic components");
-    m.def("read_mas", &read_mas, "Read a MAS object by key");
+    m.def("load_magnetics_batch", &load_magnetics_batch,
+        "Load magnetic components in parallel, returning \"0\" or the error message for each of them",
+        py::arg("keys"), py::arg("magnetics"), py::arg("expand") = false);
+    m.def("read_mas", &read_mas, "Read a MAS object by key, returning an errorMessage if it is not loaded or was evicted",
+        py::call_guard<py::gil_scoped_release>());
+    m.def("set_mas_memory_budget", &set_mas_memory_budget,
+        "Bound the memory used by loaded MAS objects, evicting the least recently read ones. 0 means unbounded",
+        py::arg("memory_budget"));
+    m.def("get_mas_statistics", &get_mas_statistics, "Number, size, hits, misses and evictions of loaded MAS objects");
+    m.def("clear_mas", &clear_mas, "Remove all loaded MAS objects");
     m.def("load_core_materials", &load_core_materials, "Load core materials into database");
     m.def("load_core_shapes", &load_core_shapes, "Load core shapes into database");
     m.def("load_wires", &load_wires, "Load wires into database");
@@ -218,8 +1202,23 @@ void register_database_bindings(py::module& m) {
     m.def("is_core_material_database_empty", &is_core_material_database_empty, "Check if core material database is empty");
     m.def("is_core_shape_database_empty", &is_core_shape_database_empty, "Check if core shape database is empty");
     m.def("is_wire_database_empty", &is_wire_database_empty, "Check if wire database is empty");
-    m.def("load_magnetics_from_file", &load_magnetics_from_file, "Load magnetic components from file");
+    m.def("load_magnetics_from_file", &load_magnetics_from_file,
+        "Load magnetic components from an ndjson file, skipping malformed lines. progress(processed, loaded, skipped) is called periodically",
+        py::arg("path"), py::arg("expand"), py::arg("progress") = py::none());
+    m.def("get_magnetics_file_load_report", &get_magnetics_file_load_report,
+        "Line counts, skipped lines with their errors and duration of the last load_magnetics_from_file call");
     m.def("clear_magnetic_cache", &clear_magnetic_cache, "Clear cached magnetic calculations");
+    m.def("set_autocomplete_cache_directory", &set_autocomplete_cache_directory,
+        "Persist autocompleted magnetics in directory, capped at maximum_size bytes. An empty directory disables the cache",
+        py::arg("directory"), py::arg("maximum_size") = size_t{1} << 30);
+    m.def("clear_autocomplete_cache", &clear_autocomplete_cache, "Delete every entry of the persistent autocomplete cache");
+    m.def("get_autocomplete_cache_statistics", &get_autocomplete_cache_statistics,
+        "Directory, size, hits, misses, writes and evictions of the persistent autocomplete cache");
+    m.def("fuzzy_find", &fuzzy_find,
+        "Find the k names closest to query in a database (core_shape, core_material, wire or bobbin), with scores from 0 to 100",
+        py::arg("category"), py::arg("query"), py::arg("k") = 10);
+    m.def("get_memory_usage", &get_memory_usage,
+        "Estimated bytes and record counts of every database, loaded MAS objects, cached magnetics and interned strings, with the process resident size");
 }
 
 } // namespace PyMKF
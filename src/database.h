@@ -4,22 +4,48 @@
 
 namespace PyMKF {
 
-void load_databases(json databasesJson);
-std::string read_databases(std::string path, bool addInternalData);
+// Bump whenever the snapshot layout or the encoding of its records changes
+constexpr uint32_t snapshotSchemaVersion = 2;
+
+// Incremented every time the databases are loaded, reloaded or cleared, so derived indexes know when to rebuild
+uint64_t get_database_version();
+// Fingerprint of what the databases were loaded from, 0 for the data built into the module. Unlike
+// the version it is the same in every process that loaded the same data the same way.
+uint64_t get_database_fingerprint();
+
+void load_databases(json databasesJson, bool lazy);
+std::string read_databases(std::string path, bool addInternalData, bool lazy);
+json get_database_ingestion_statistics();
+json reload_databases(std::string path);
+std::string save_database_snapshot(std::string path);
+std::string load_database_snapshot(std::string path, bool lazy);
 std::string load_mas(std::string key, json masJson, bool expand);
 std::string load_magnetic(std::string key, json magneticJson, bool expand);
 std::string load_magnetics(std::string keys, json magneticJsons, bool expand);
+std::vector<std::string> load_magnetics_batch(std::vector<std::string> keys, std::vector<json> magneticJsons, bool expand);
 json read_mas(std::string key);
+void set_mas_memory_budget(size_t memoryBudget);
+json get_mas_statistics();
+void clear_mas();
 
 size_t load_core_materials(std::string fileToLoad);
 size_t load_core_shapes(std::string fileToLoad);
 size_t load_wires(std::string fileToLoad);
 void clear_databases();
+// Materializes lazy records and loads any empty database, so worker threads only ever read them.
+// Parallel bindings call it with the GIL held, before releasing it: MKF object construction, core
+// processing and autocompletion are only run concurrently on databases that no longer change, and
+// tests/test_database.py and tests/test_core.py check the parallel results against serial ones.
+void ensure_databases_loaded();
+// Loads only the core material and shape databases if they are empty. Lazy records are left as they
+// are, so callers materialize the ones their input references first.
+void ensure_core_databases_loaded();
 bool is_core_material_database_empty();
 bool is_core_shape_database_empty();
 bool is_wire_database_empty();
 
-std::string load_magnetics_from_file(std::string path, bool expand);
+std::string load_magnetics_from_file(std::string path, bool expand, std::optional<py::function> progress);
+json get_magnetics_file_load_report();
 std::string clear_magnetic_cache();
 
 void register_database_bindings(py::module& m);
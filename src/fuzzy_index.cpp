@@ -0,0 +1,209 @@
+#include "fuzzy_index.h"
+#include "database.h"
+#include "lazy_database.h"
+#include "string_pool.h"
+#include <algorithm>
+#include <mutex>
+#include <rapidfuzz/fuzz.hpp>
+
+namespace PyMKF {
+
+namespace {
+
+// Names are short, so scoring a few dozen candidates costs less than ranking them finely
+constexpr size_t minimumCandidates = 64;
+constexpr size_t candidatesPerResult = 8;
+
+std::string normalize_name(const std::string& name) {
+    std::string normalized = name;
+    for (auto& character : normalized) {
+        character = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+    }
+    return normalized;
+}
+
+// Padded like pg_trgm, so the start of a word weighs more than its middle
+std::vector<uint32_t> get_trigrams(const std::string& normalizedName) {
+    std::string padded = "  " + normalizedName + " ";
+    std::vector<uint32_t> trigrams;
+    for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+        trigrams.push_back(static_cast<uint32_t>(static_cast<unsigned char>(padded[i])) << 16 |
+                           static_cast<uint32_t>(static_cast<unsigned char>(padded[i + 1])) << 8 |
+                           static_cast<uint32_t>(static_cast<unsigned char>(padded[i + 2])));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+template<typename Database>
+std::vector<std::string> get_names(const Database& database) {
+    std::vector<std::string> names;
+    names.reserve(database.size());
+    for (auto& [name, record] : database) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+struct CachedFuzzyIndex {
+    std::shared_ptr<const FuzzyIndex> index;
+    uint64_t databaseVersion = 0;
+    size_t databaseSize = 0;
+};
+
+std::mutex fuzzyIndexMutex;
+std::map<std::string, CachedFuzzyIndex> fuzzyIndexes;
+
+} // namespace
+
+FuzzyIndex::FuzzyIndex(std::vector<std::string> names) {
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    _names.reserve(names.size());
+    for (auto& name : names) {
+        _names.push_back(stringPool.intern(name));
+    }
+    _normalizedNames.reserve(_names.size());
+    _trigramCounts.reserve(_names.size());
+    for (uint32_t id = 0; id < _names.size(); ++id) {
+        _normalizedNames.push_back(normalize_name(std::string(_names[id])));
+        auto trigrams = get_trigrams(_normalizedNames.back());
+        _trigramCounts.push_back(static_cast<uint32_t>(trigrams.size()));
+        for (auto trigram : trigrams) {
+            _postings[trigram].push_back(id);
+        }
+    }
+}
+
+std::vector<FuzzyIndex::Match> FuzzyIndex::find(const std::string& query, size_t k) const {
+    std::vector<Match> matches;
+    if (k == 0 || _names.empty()) {
+        return matches;
+    }
+    auto normalizedQuery = normalize_name(query);
+    auto queryTrigrams = get_trigrams(normalizedQuery);
+
+    std::vector<uint32_t> sharedTrigrams(_names.size(), 0);
+    std::vector<uint32_t> candidates;
+    for (auto trigram : queryTrigrams) {
+        auto postings = _postings.find(trigram);
+        if (postings == _postings.end()) {
+            continue;
+        }
+        for (auto id : postings->second) {
+            if (sharedTrigrams[id]++ == 0) {
+                candidates.push_back(id);
+            }
+        }
+    }
+
+    size_t maximumCandidates = std::max(minimumCandidates, k * candidatesPerResult);
+    if (candidates.empty()) {
+        // Nothing in common at all, rapidfuzz may still find something worth returning
+        candidates.resize(_names.size());
+        for (uint32_t id = 0; id < _names.size(); ++id) {
+            candidates[id] = id;
+        }
+    }
+    else if (candidates.size() > maximumCandidates) {
+        // Keep the names with the highest Dice coefficient over trigrams
+        auto similarity = [&](uint32_t id) {
+            return 2.0 * sharedTrigrams[id] / (queryTrigrams.size() + _trigramCounts[id]);
+        };
+        std::nth_element(candidates.begin(), candidates.begin() + maximumCandidates, candidates.end(), [&](uint32_t a, uint32_t b) {
+            double similarityA = similarity(a);
+            double similarityB = similarity(b);
+            return similarityA > similarityB || (similarityA == similarityB && a < b);
+        });
+        candidates.resize(maximumCandidates);
+    }
+
+    rapidfuzz::fuzz::CachedWRatio<char> scorer(normalizedQuery);
+    matches.reserve(candidates.size());
+    for (auto id : candidates) {
+        matches.push_back({std::string(_names[id]), scorer.similarity(_normalizedNames[id])});
+    }
+    auto last = matches.begin() + std::min(k, matches.size());
+    std::partial_sort(matches.begin(), last, matches.end(), [](const Match& a, const Match& b) {
+        return a.score > b.score || (a.score == b.score && a.name < b.name);
+    });
+    matches.erase(last, matches.end());
+    return matches;
+}
+
+std::shared_ptr<const FuzzyIndex> get_fuzzy_index(const std::string& category) {
+    std::lock_guard<std::mutex> lock(fuzzyIndexMutex);
+    materialize_all_records();
+    size_t databaseSize;
+    if (category == "core_shape") {
+        if (OpenMagnetics::coreShapeDatabase.empty()) {
+            OpenMagnetics::load_core_shapes();
+        }
+        databaseSize = OpenMagnetics::coreShapeDatabase.size();
+    }
+    else if (category == "core_material") {
+        if (OpenMagnetics::coreMaterialDatabase.empty()) {
+            OpenMagnetics::load_core_materials();
+        }
+        databaseSize = OpenMagnetics::coreMaterialDatabase.size();
+    }
+    else if (category == "wire") {
+        if (OpenMagnetics::wireDatabase.empty()) {
+            OpenMagnetics::load_wires();
+        }
+        databaseSize = OpenMagnetics::wireDatabase.size();
+    }
+    else if (category == "bobbin") {
+        if (OpenMagnetics::bobbinDatabase.empty()) {
+            OpenMagnetics::load_bobbins();
+        }
+        databaseSize = OpenMagnetics::bobbinDatabase.size();
+    }
+    else {
+        throw std::invalid_argument("Unknown category " + category + ", expected core_shape, core_material, wire or bobbin");
+    }
+
+    auto& cached = fuzzyIndexes[category];
+    if (cached.index && cached.databaseVersion == get_database_version() && cached.databaseSize == databaseSize) {
+        return cached.index;
+    }
+    std::vector<std::string> names;
+    if (category == "core_shape") {
+        names = get_names(OpenMagnetics::coreShapeDatabase);
+    }
+    else if (category == "core_material") {
+        names = get_names(OpenMagnetics::coreMaterialDatabase);
+    }
+    else if (category == "wire") {
+        names = get_names(OpenMagnetics::wireDatabase);
+    }
+    else {
+        names = get_names(OpenMagnetics::bobbinDatabase);
+    }
+    cached.databaseVersion = get_database_version();
+    cached.databaseSize = databaseSize;
+    cached.index = std::make_shared<const FuzzyIndex>(std::move(names));
+    return cached.index;
+}
+
+json fuzzy_find(std::string category, std::string query, size_t k) {
+    try {
+        auto index = get_fuzzy_index(category);
+        json result = json::array();
+        for (auto& match : index->find(query, k)) {
+            json aux;
+            aux["name"] = match.name;
+            aux["score"] = match.score;
+            result.push_back(aux);
+        }
+        return result;
+    }
+    catch (const std::exception &exc) {
+        json exception;
+        exception["data"] = "Exception: " + std::string{exc.what()};
+        return exception;
+    }
+}
+
+} // namespace PyMKF
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "common.h"
+#include <memory>
+#include <unordered_map>
+
+namespace PyMKF {
+
+// Approximate name search over one database. Names sharing trigrams with the query are
+// prefiltered through an inverted index, and only the best of them are scored with rapidfuzz.
+class FuzzyIndex {
+  public:
+    struct Match {
+        std::string name;
+        double score;
+    };
+
+    explicit FuzzyIndex(std::vector<std::string> names);
+
+    // Best k names by rapidfuzz WRatio (0 to 100), ties broken by name
+    std::vector<Match> find(const std::string& query, size_t k) const;
+    size_t size() const { return _names.size(); }
+
+  private:
+    // Interned in stringPool
+    std::vector<std::string_view> _names;
+    std::vector<std::string> _normalizedNames;
+    std::vector<uint32_t> _trigramCounts;
+    // Trigram to the ids of the names containing it, in increasing order
+    std::unordered_map<uint32_t, std::vector<uint32_t>> _postings;
+};
+
+// Index over the names and aliases of a database: "core_shape", "core_material", "wire" or
+// "bobbin". Rebuilt the first time it is requested after a load, reload or clear.
+std::shared_ptr<const FuzzyIndex> get_fuzzy_index(const std::string& category);
+
+json fuzzy_find(std::string category, std::string query, size_t k);
+
+} // namespace PyMKF
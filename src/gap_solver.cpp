@@ -0,0 +1,282 @@
+#include "gap_solver.h"
+#include "core_processing_cache.h"
+#include "lazy_database.h"
+#include <cmath>
+#include <limits>
+#include <set>
+
+namespace PyMKF {
+
+namespace {
+
+// Search limits for the gap length, in meters
+constexpr double minimumGapLength = 1e-6;
+constexpr double maximumGapLength = 0.05;
+constexpr double defaultInitialGapLength = 1e-4;
+
+OpenMagnetics::ReluctanceModels get_reluctance_model_name(json modelsData) {
+    auto reluctanceModelName = OpenMagnetics::defaults.reluctanceModelDefault;
+    if (modelsData.is_object() && modelsData.contains("reluctance")) {
+        OpenMagnetics::from_json(modelsData["reluctance"], reluctanceModelName);
+    }
+    return reluctanceModelName;
+}
+
+double get_magnetizing_inductance(OpenMagnetics::MagnetizingInductance& magnetizingInductanceObj, OpenMagnetics::Core& core, OpenMagnetics::Coil& coil, const OperatingPoint& operatingPoint) {
+    // The model may fill in the magnetizing current, so each evaluation gets a fresh copy
+    auto evaluatedOperatingPoint = operatingPoint;
+    return magnetizingInductanceObj.calculate_inductance_from_number_turns_and_gapping(core, coil, &evaluatedOperatingPoint).get_magnetizing_inductance().get_nominal().value();
+}
+
+} // namespace
+
+RootSearchResult find_root_brent(const std::function<double(double)>& function, double a, double b, double functionA, double functionB, double tolerance, size_t maximumIterations) {
+    if (std::abs(functionA) <= tolerance) {
+        return {a, functionA, 0, true};
+    }
+    if (std::abs(functionB) <= tolerance) {
+        return {b, functionB, 0, true};
+    }
+    if ((functionA > 0) == (functionB > 0)) {
+        throw std::invalid_argument("Root is not bracketed");
+    }
+    double c = b;
+    double functionC = functionB;
+    double step = b - a;
+    double previousStep = step;
+    size_t iterations = 0;
+    for (; iterations < maximumIterations; ++iterations) {
+        // Keep the root between b and c, with b the best estimate so far
+        if ((functionB > 0) == (functionC > 0)) {
+            c = a;
+            functionC = functionA;
+            step = b - a;
+            previousStep = step;
+        }
+        if (std::abs(functionC) < std::abs(functionB)) {
+            a = b;
+            b = c;
+            c = a;
+            functionA = functionB;
+            functionB = functionC;
+            functionC = functionA;
+        }
+        double xTolerance = 2 * std::numeric_limits<double>::epsilon() * std::abs(b) + std::numeric_limits<double>::min();
+        double middle = (c - b) / 2;
+        if (std::abs(functionB) <= tolerance || std::abs(middle) <= xTolerance) {
+            return {b, functionB, iterations, std::abs(functionB) <= tolerance};
+        }
+        if (std::abs(previousStep) >= xTolerance && std::abs(functionA) > std::abs(functionB)) {
+            // Secant when only two points are known, inverse quadratic interpolation otherwise
+            double s = functionB / functionA;
+            double p;
+            double q;
+            if (a == c) {
+                p = 2 * middle * s;
+                q = 1 - s;
+            }
+            else {
+                double r = functionB / functionC;
+                q = functionA / functionC;
+                p = s * (2 * middle * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0) {
+                q = -q;
+            }
+            else {
+                p = -p;
+            }
+            // Fall back to bisection when interpolation lands outside the bracket or converges slowly
+            if (2 * p < std::min(3 * middle * q - std::abs(xTolerance * q), std::abs(previousStep * q))) {
+                previousStep = step;
+                step = p / q;
+            }
+            else {
+                step = middle;
+                previousStep = step;
+            }
+        }
+        else {
+            step = middle;
+            previousStep = step;
+        }
+        a = b;
+        functionA = functionB;
+        b += std::abs(step) > xTolerance ? step : (middle > 0 ? xTolerance : -xTolerance);
+        functionB = function(b);
+    }
+    return {b, functionB, iterations, std::abs(functionB) <= tolerance};
+}
+
+json solve_gapping_from_number_turns_and_inductance(json coreData, json coilData, json inputsData, json modelsData, double tolerance, size_t maximumIterations, bool includeCore) {
+    try {
+        materialize_references(coreData, coilData, inputsData, modelsData);
+        OpenMagnetics::Core core(coreData, false, false, false);
+        OpenMagnetics::Coil coil(coilData);
+        OpenMagnetics::Inputs inputs(inputsData);
+        double targetInductance = OpenMagnetics::resolve_dimensional_values(inputs.get_design_requirements().get_magnetizing_inductance());
+        auto operatingPoint = inputs.get_operating_point(0);
+        OpenMagnetics::MagnetizingInductance magnetizingInductanceObj(get_reluctance_model_name(modelsData));
+
+        auto gapping = core.get_functional_description().get_gapping();
+        double initialGapLength = 0;
+        bool hasGap = false;
+        for (auto& gap : gapping) {
+            if (gap.get_type() != GapType::RESIDUAL) {
+                hasGap = true;
+                initialGapLength = std::max(initialGapLength, gap.get_length());
+            }
+        }
+        if (!hasGap) {
+            throw std::invalid_argument("Core has no subtractive or additive gap to solve for");
+        }
+        if (initialGapLength <= 0) {
+            initialGapLength = defaultInitialGapLength;
+        }
+
+        // Gap lengths do not change the processed description, only the gaps need reprocessing
+        core.process_data();
+        auto apply_gap_length = [&](double gapLength) {
+            auto solvedGapping = gapping;
+            for (auto& gap : solvedGapping) {
+                if (gap.get_type() != GapType::RESIDUAL) {
+                    gap.set_length(gapLength);
+                }
+            }
+            core.get_mutable_functional_description().set_gapping(solvedGapping);
+            core.process_gap();
+        };
+        size_t evaluations = 0;
+        // Inductance falls close to inversely with gap length, so both are searched in log space
+        auto logInductanceRatio = [&](double logGapLength) {
+            ++evaluations;
+            apply_gap_length(std::exp(logGapLength));
+            return std::log(get_magnetizing_inductance(magnetizingInductanceObj, core, coil, operatingPoint) / targetInductance);
+        };
+        double logTolerance = std::log1p(tolerance);
+        double lowerBound = std::log(minimumGapLength);
+        double upperBound = std::log(maximumGapLength);
+
+        double a = std::clamp(std::log(initialGapLength), lowerBound, upperBound);
+        double functionA = logInductanceRatio(a);
+        RootSearchResult solution{a, functionA, 0, std::abs(functionA) <= logTolerance};
+        if (!solution.converged) {
+            // Too much inductance means the gap has to grow
+            double direction = functionA > 0 ? 1 : -1;
+            double step = std::log(2.0);
+            double b = a;
+            double functionB = functionA;
+            bool bracketed = false;
+            while (evaluations < maximumIterations) {
+                a = b;
+                functionA = functionB;
+                b = std::clamp(a + direction * step, lowerBound, upperBound);
+                if (b == a) {
+                    break;
+                }
+                functionB = logInductanceRatio(b);
+                if ((functionB > 0) != (functionA > 0) || functionB == 0) {
+                    bracketed = true;
+                    break;
+                }
+                step *= 2;
+            }
+            if (bracketed) {
+                size_t remainingIterations = maximumIterations > evaluations ? maximumIterations - evaluations : 0;
+                solution = find_root_brent(logInductanceRatio, a, b, functionA, functionB, logTolerance, remainingIterations);
+            }
+            else {
+                // The inductance cannot be reached inside the search limits, report the closest limit
+                solution = {b, functionB, 0, false};
+            }
+        }
+
+        double gapLength = std::exp(solution.x);
+        apply_gap_length(gapLength);
+        json result;
+        result["gapLength"] = gapLength;
+        result["gapping"] = json::array();
+        for (auto& gap : core.get_functional_description().get_gapping()) {
+            json aux;
+            to_json(aux, gap);
+            result["gapping"].push_back(aux);
+        }
+        result["magnetizingInductance"] = targetInductance * std::exp(solution.residual);
+        result["targetMagnetizingInductance"] = targetInductance;
+        result["residual"] = std::expm1(solution.residual);
+        result["iterations"] = evaluations;
+        result["converged"] = solution.converged;
+        if (includeCore) {
+            auto geometricalDescription = core.create_geometrical_description();
+            core.set_geometrical_description(geometricalDescription);
+            to_json(result["core"], core);
+        }
+        return result;
+    }
+    catch (const std::exception &exc) {
+        json exception;
+        exception["data"] = "Exception: " + std::string{exc.what()};
+        return exception;
+    }
+}
+
+json solve_number_turns_from_gapping_and_inductance(json coreData, json coilData, json inputsData, json modelsData, double tolerance, size_t maximumIterations) {
+    try {
+        materialize_references(coreData, coilData, inputsData, modelsData);
+        OpenMagnetics::Core core(coreData, false, false, false);
+        process_core(core);
+        OpenMagnetics::Coil coil(coilData);
+        OpenMagnetics::Inputs inputs(inputsData);
+        double targetInductance = OpenMagnetics::resolve_dimensional_values(inputs.get_design_requirements().get_magnetizing_inductance());
+        auto operatingPoint = inputs.get_operating_point(0);
+        OpenMagnetics::MagnetizingInductance magnetizingInductanceObj(get_reluctance_model_name(modelsData));
+
+        // Turns are whole, so the Newton step is taken on the real number of turns and rounded to
+        // evaluate. A number of turns seen before means the rounded iteration has settled, which
+        // only counts as converged if the best whole number of turns is within tolerance.
+        int64_t numberTurns = std::max<int64_t>(1, coil.get_functional_description()[0].get_number_turns());
+        double exactNumberTurns = static_cast<double>(numberTurns);
+        std::set<int64_t> evaluatedNumbersTurns;
+        int64_t bestNumberTurns = numberTurns;
+        double bestResidual = std::numeric_limits<double>::infinity();
+        bool settled = false;
+        size_t iterations = 0;
+        while (iterations < maximumIterations) {
+            ++iterations;
+            evaluatedNumbersTurns.insert(numberTurns);
+            coil.get_mutable_functional_description()[0].set_number_turns(numberTurns);
+            double inductance = get_magnetizing_inductance(magnetizingInductanceObj, core, coil, operatingPoint);
+            double residual = inductance / targetInductance - 1;
+            if (std::abs(residual) < std::abs(bestResidual)) {
+                bestResidual = residual;
+                bestNumberTurns = numberTurns;
+            }
+            exactNumberTurns = numberTurns * std::sqrt(targetInductance / inductance);
+            int64_t nextNumberTurns = std::max<int64_t>(1, std::llround(exactNumberTurns));
+            if (std::abs(residual) <= tolerance || evaluatedNumbersTurns.contains(nextNumberTurns)) {
+                settled = true;
+                break;
+            }
+            numberTurns = nextNumberTurns;
+        }
+
+        json result;
+        result["numberTurns"] = bestNumberTurns;
+        result["exactNumberTurns"] = exactNumberTurns;
+        result["magnetizingInductance"] = targetInductance * (1 + bestResidual);
+        result["targetMagnetizingInductance"] = targetInductance;
+        result["residual"] = bestResidual;
+        result["iterations"] = iterations;
+        result["settled"] = settled;
+        result["converged"] = std::abs(bestResidual) <= tolerance;
+        return result;
+    }
+    catch (const std::exception &exc) {
+        json exception;
+        exception["data"] = "Exception: " + std::string{exc.what()};
+        return exception;
+    }
+}
+
+} // namespace PyMKF
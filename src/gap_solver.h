@@ -0,0 +1,33 @@
+#pragma once
+
+#include "common.h"
+
+namespace PyMKF {
+
+// Solvers for the gap length or number of turns that give the magnetizing inductance required by
+// the inputs, reporting how many inductance evaluations they took and the relative residual left.
+// The core is processed once and only its gaps are reprocessed between evaluations.
+
+struct RootSearchResult {
+    double x;
+    double residual;
+    size_t iterations;
+    bool converged;
+};
+
+// Brent's method over [a, b], where function(a) and function(b) have opposite signs. Stops once
+// |function(x)| <= tolerance or the bracket cannot shrink any further.
+RootSearchResult find_root_brent(const std::function<double(double)>& function, double a, double b, double functionA, double functionB, double tolerance, size_t maximumIterations);
+
+// Length shared by every subtractive or additive gap of the core, which must have at least one.
+// Residual gaps are kept as given. The search brackets outwards from the current gap length in
+// log space, then refines with Brent's method until the inductance is within tolerance, relative.
+json solve_gapping_from_number_turns_and_inductance(json coreData, json coilData, json inputsData, json modelsData, double tolerance, size_t maximumIterations, bool includeCore);
+
+// Number of turns of the first winding, by Newton steps on log(inductance) against log(turns),
+// which converge in one step when inductance grows exactly as turns squared. Reports both the
+// exact solution and the nearest whole number of turns. "settled" tells the rounded iteration
+// stopped on its own, "converged" that the whole number of turns is within tolerance, relative.
+json solve_number_turns_from_gapping_and_inductance(json coreData, json coilData, json inputsData, json modelsData, double tolerance, size_t maximumIterations);
+
+} // namespace PyMKF
@@ -0,0 +1,313 @@
+#include "lazy_database.h"
+#include "mapped_file.h"
+#include "ndjson.h"
+#include "parallel.h"
+#include "string_pool.h"
+#include <atomic>
+#include <cmrc/cmrc.hpp>
+#include <mutex>
+
+CMRC_DECLARE(data);
+
+namespace PyMKF {
+
+namespace {
+
+struct LazyRecord {
+    // Raw ndjson line, pointing into a mapped file or the embedded resources
+    std::string_view text;
+    // Record handed over already parsed through load_databases
+    std::optional<json> document;
+    // Set when text is a MessagePack record of a snapshot instead of an ndjson line
+    bool isMessagePack = false;
+    // Set when this entry is an alias of another record, materialized under the alias name
+    bool isAlias = false;
+    bool materialized = false;
+};
+
+struct LazySection {
+    // Keys are interned in stringPool
+    std::unordered_map<std::string_view, LazyRecord> records;
+    size_t numberMaterialized = 0;
+};
+
+std::atomic<bool> lazyLoadingEnabled{false};
+std::recursive_mutex lazyMutex;
+std::vector<LazySection> lazySections(ndjsonDatabaseFiles.size());
+// Owned copies of the files read by path, which the index points into
+std::vector<std::unique_ptr<const std::string>> lazySources;
+// Snapshots are only ever replaced by renaming a new file over them, so unlike the ndjson files
+// they are safe to keep mapped: the mapping goes on reading the file it was made from
+std::shared_ptr<const MappedFile> lazySnapshot;
+
+void collect_references(const json& document, std::vector<std::string>& names) {
+    if (document.is_string()) {
+        names.push_back(document.get<std::string>());
+    }
+    else if (document.is_structured()) {
+        for (auto& element : document) {
+            collect_references(element, names);
+        }
+    }
+}
+
+void materialize(size_t sectionIndex, const std::string& key, LazyRecord& lazyRecord) {
+    if (lazyRecord.materialized) {
+        return;
+    }
+    json recordJson;
+    if (lazyRecord.document) {
+        recordJson = *lazyRecord.document;
+    }
+    else if (lazyRecord.isMessagePack) {
+        auto data = reinterpret_cast<const uint8_t*>(lazyRecord.text.data());
+        recordJson = json::from_msgpack(data, data + lazyRecord.text.size());
+    }
+    else {
+        recordJson = json::parse(lazyRecord.text);
+    }
+    if (lazyRecord.isAlias) {
+        recordJson["name"] = key;
+    }
+    insert_database_record(sectionIndex, key, recordJson);
+    lazyRecord.materialized = true;
+    lazySections[sectionIndex].numberMaterialized++;
+
+    // Records name other records too, e.g. a wire its conductor and coating materials
+    std::vector<std::string> references;
+    collect_references(recordJson, references);
+    for (auto& reference : references) {
+        materialize_record(reference);
+    }
+}
+
+// Builds the name index of one ndjson text, scanning line-aligned chunks in parallel
+void index_ndjson(size_t sectionIndex, std::string_view text) {
+    constexpr size_t chunkSize = 256 * 1024;
+    auto chunks = split_ndjson_lines(text, chunkSize);
+    std::vector<std::vector<std::pair<NdjsonRecordNames, std::string_view>>> chunkNames(chunks.size());
+    parallel_for(chunks.size(), [&](size_t chunkIndex) {
+        auto [begin, end] = chunks[chunkIndex];
+        for_each_ndjson_line(text.substr(begin, end - begin), [&](std::string_view line) {
+            chunkNames[chunkIndex].emplace_back(scan_ndjson_record_names(line), line);
+        });
+    });
+
+    auto& records = lazySections[sectionIndex].records;
+    for (auto& names : chunkNames) {
+        for (auto& [recordNames, line] : names) {
+            records.insert_or_assign(stringPool.intern(recordNames.name), LazyRecord{line, std::nullopt, false, false, false});
+            for (auto& alias : recordNames.aliases) {
+                records.insert_or_assign(stringPool.intern(alias), LazyRecord{line, std::nullopt, false, true, false});
+            }
+        }
+    }
+}
+
+void index_internal_data() {
+    auto fs = cmrc::data::get_filesystem();
+    for (size_t sectionIndex = 0; sectionIndex < ndjsonDatabaseFiles.size(); ++sectionIndex) {
+        auto resource = "MAS/data/" + ndjsonDatabaseFiles[sectionIndex].second;
+        if (!fs.exists(resource)) {
+            continue;
+        }
+        auto file = fs.open(resource);
+        index_ndjson(sectionIndex, std::string_view(file.begin(), file.end() - file.begin()));
+    }
+}
+
+void reset_lazy_index() {
+    for (auto& section : lazySections) {
+        section.records.clear();
+        section.numberMaterialized = 0;
+    }
+    lazySources.clear();
+    lazySnapshot.reset();
+}
+
+} // namespace
+
+bool is_lazy_loading_enabled() {
+    return lazyLoadingEnabled.load();
+}
+
+void enable_lazy_loading_from_json(json databasesJson, bool addInternalData) {
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    OpenMagnetics::clear_databases();
+    reset_lazy_index();
+    if (addInternalData) {
+        index_internal_data();
+    }
+    for (size_t sectionIndex = 0; sectionIndex < ndjsonDatabaseFiles.size(); ++sectionIndex) {
+        auto& sectionName = ndjsonDatabaseFiles[sectionIndex].first;
+        if (!databasesJson.contains(sectionName) || !databasesJson[sectionName].is_object()) {
+            continue;
+        }
+        auto& records = lazySections[sectionIndex].records;
+        for (auto& [name, recordJson] : databasesJson[sectionName].items()) {
+            auto& lazyRecord = records.insert_or_assign(stringPool.intern(name), LazyRecord{{}, std::move(recordJson), false, false, false}).first->second;
+            // Aliases are indexed as in the ndjson path, each materialized from its own copy of the record
+            if (!lazyRecord.document->contains("aliases") || !lazyRecord.document->at("aliases").is_array()) {
+                continue;
+            }
+            auto aliases = lazyRecord.document->at("aliases");
+            for (auto& alias : aliases) {
+                if (alias.is_string()) {
+                    records.insert_or_assign(stringPool.intern(alias.get_ref<const std::string&>()), LazyRecord{{}, *lazyRecord.document, false, true, false});
+                }
+            }
+        }
+    }
+    lazyLoadingEnabled.store(true);
+}
+
+uint64_t enable_lazy_loading_from_path(std::string path, bool addInternalData) {
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    uint64_t hash = hash_text(addInternalData ? "internal" : "");
+    OpenMagnetics::clear_databases();
+    reset_lazy_index();
+    if (addInternalData) {
+        index_internal_data();
+    }
+    auto masPath = std::filesystem::path{path};
+    for (size_t sectionIndex = 0; sectionIndex < ndjsonDatabaseFiles.size(); ++sectionIndex) {
+        auto filePath = masPath / ndjsonDatabaseFiles[sectionIndex].second;
+        if (!std::filesystem::exists(filePath)) {
+            continue;
+        }
+        // Copied out of the mapping, which still skips the eager parse: the user may rewrite the file
+        // in place before reloading it, and a truncated mapping cannot be read anymore
+        std::unique_ptr<const std::string> text;
+        {
+            MappedFile file(filePath);
+            text = std::make_unique<const std::string>(file.view());
+        }
+        hash = hash_text(ndjsonDatabaseFiles[sectionIndex].second, hash_text(*text, hash));
+        index_ndjson(sectionIndex, *text);
+        lazySources.push_back(std::move(text));
+    }
+    lazyLoadingEnabled.store(true);
+    return hash;
+}
+
+void enable_lazy_loading_from_snapshot(std::shared_ptr<const MappedFile> file, const std::map<std::string, SnapshotRecordViews>& sections) {
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    OpenMagnetics::clear_databases();
+    reset_lazy_index();
+    for (size_t sectionIndex = 0; sectionIndex < ndjsonDatabaseFiles.size(); ++sectionIndex) {
+        auto section = sections.find(ndjsonDatabaseFiles[sectionIndex].first);
+        if (section == sections.end()) {
+            continue;
+        }
+        // Aliases were saved as records of their own, already carrying their name
+        auto& records = lazySections[sectionIndex].records;
+        for (auto& [name, data] : section->second) {
+            records.insert_or_assign(stringPool.intern(name), LazyRecord{data, std::nullopt, true, false, false});
+        }
+    }
+    lazySnapshot = std::move(file);
+    lazyLoadingEnabled.store(true);
+}
+
+void disable_lazy_loading() {
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    lazyLoadingEnabled.store(false);
+    reset_lazy_index();
+}
+
+void materialize_record(const std::string& name) {
+    if (!is_lazy_loading_enabled()) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    for (size_t sectionIndex = 0; sectionIndex < lazySections.size(); ++sectionIndex) {
+        auto& records = lazySections[sectionIndex].records;
+        auto it = records.find(name);
+        if (it != records.end()) {
+            materialize(sectionIndex, std::string(it->first), it->second);
+        }
+    }
+}
+
+void materialize_all_records() {
+    if (!is_lazy_loading_enabled()) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    for (size_t sectionIndex = 0; sectionIndex < lazySections.size(); ++sectionIndex) {
+        auto& section = lazySections[sectionIndex];
+        if (section.numberMaterialized == section.records.size()) {
+            continue;
+        }
+        for (auto& [name, lazyRecord] : section.records) {
+            materialize(sectionIndex, std::string(name), lazyRecord);
+        }
+    }
+}
+
+void materialize_section(const std::string& sectionName) {
+    if (!is_lazy_loading_enabled()) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    for (size_t sectionIndex = 0; sectionIndex < ndjsonDatabaseFiles.size(); ++sectionIndex) {
+        if (ndjsonDatabaseFiles[sectionIndex].first != sectionName) {
+            continue;
+        }
+        auto& section = lazySections[sectionIndex];
+        if (section.numberMaterialized == section.records.size()) {
+            return;
+        }
+        for (auto& [name, lazyRecord] : section.records) {
+            materialize(sectionIndex, std::string(name), lazyRecord);
+        }
+        return;
+    }
+    throw std::invalid_argument("Unknown database section " + sectionName);
+}
+
+void materialize_references(const json& document) {
+    if (!is_lazy_loading_enabled()) {
+        return;
+    }
+    std::vector<std::string> names;
+    collect_references(document, names);
+    for (auto& name : names) {
+        materialize_record(name);
+    }
+}
+
+size_t count_lazy_records(const std::string& sectionName) {
+    if (!is_lazy_loading_enabled()) {
+        return 0;
+    }
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    for (size_t sectionIndex = 0; sectionIndex < ndjsonDatabaseFiles.size(); ++sectionIndex) {
+        if (ndjsonDatabaseFiles[sectionIndex].first == sectionName) {
+            return lazySections[sectionIndex].records.size();
+        }
+    }
+    return 0;
+}
+
+json get_lazy_loading_statistics() {
+    std::lock_guard<std::recursive_mutex> lock(lazyMutex);
+    json statistics;
+    statistics["enabled"] = is_lazy_loading_enabled();
+    size_t totalIndexed = 0;
+    size_t totalMaterialized = 0;
+    for (size_t sectionIndex = 0; sectionIndex < lazySections.size(); ++sectionIndex) {
+        auto& section = lazySections[sectionIndex];
+        json sectionStatistics;
+        sectionStatistics["indexed"] = section.records.size();
+        sectionStatistics["materialized"] = section.numberMaterialized;
+        statistics[ndjsonDatabaseFiles[sectionIndex].first] = sectionStatistics;
+        totalIndexed += section.records.size();
+        totalMaterialized += section.numberMaterialized;
+    }
+    statistics["indexed"] = totalIndexed;
+    statistics["materialized"] = totalMaterialized;
+    return statistics;
+}
+
+} // namespace PyMKF
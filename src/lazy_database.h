@@ -0,0 +1,39 @@
+#pragma once
+
+#include "common.h"
+#include "mapped_file.h"
+#include <map>
+#include <memory>
+
+namespace PyMKF {
+
+// Lazy database mode: loading only builds a name index over the raw ndjson records and a record
+// is turned into its MKF object the first time it is looked up. Bindings that enumerate a whole
+// database materialize everything first, so results never depend on what was touched before.
+bool is_lazy_loading_enabled();
+void enable_lazy_loading_from_json(json databasesJson, bool addInternalData);
+// Returns a hash of the files read
+uint64_t enable_lazy_loading_from_path(std::string path, bool addInternalData);
+// Records of a database snapshot, as name and MessagePack data views into file, per section name.
+// The mapping is kept alive by the index, and records are decoded the first time they are looked up.
+using SnapshotRecordViews = std::vector<std::pair<std::string_view, std::string_view>>;
+void enable_lazy_loading_from_snapshot(std::shared_ptr<const MappedFile> file, const std::map<std::string, SnapshotRecordViews>& sections);
+void disable_lazy_loading();
+
+void materialize_record(const std::string& name);
+void materialize_all_records();
+// Materializes one whole database, by its ndjsonDatabaseFiles section name, and what its records reference
+void materialize_section(const std::string& sectionName);
+
+// Materializes every database record referenced by name anywhere inside the given documents
+void materialize_references(const json& document);
+template <typename... Documents>
+void materialize_references(const json& document, const Documents&... documents) {
+    materialize_references(document);
+    materialize_references(documents...);
+}
+
+size_t count_lazy_records(const std::string& sectionName);
+json get_lazy_loading_statistics();
+
+} // namespace PyMKF
@@ -1,8 +1,11 @@
 #include "losses.h"
+#include "lazy_database.h"
+#include "parallel.h"
 
 namespace PyMKF {
 
 json calculate_core_losses(json coreData, json coilData, json inputsData, json modelsData) {
+    materialize_references(coreData, coilData, inputsData, modelsData);
     OpenMagnetics::Core core(coreData);
     OpenMagnetics::Coil coil(coilData);
     OpenMagnetics::Inputs inputs(inputsData);
@@ -59,6 +62,7 @@ json calculate_core_losses(json coreData, json coilData, json inputsData, json m
 }
 
 json get_core_losses_model_information(json material) {
+    materialize_references(material);
     json info;
     info["information"] = OpenMagnetics::CoreLossesModel::get_models_information();
     info["errors"] = OpenMagnetics::CoreLossesModel::get_models_errors();
@@ -77,24 +81,46 @@ json get_core_temperature_model_information() {
     return info;
 }
 
-json calculate_steinmetz_coefficients(json dataJson, json rangesJson) {
-    try {
-        std::vector<std::pair<double, double>> ranges;
-        for (auto rangeJson : rangesJson) {
-            std::pair<double, double> range{rangeJson[0], rangeJson[1]};
-            ranges.push_back(range);
-        }
-        std::vector<VolumetricLossesPoint> data;
-        for (auto datumJson : dataJson) {
-            VolumetricLossesPoint datum(datumJson);
-            data.push_back(datum);
-        }
+namespace {
 
-        auto [coefficientsPerRange, errorPerRange] = OpenMagnetics::CoreLossesSteinmetzModel::calculate_steinmetz_coefficients(data, ranges);
+std::vector<std::pair<double, double>> read_steinmetz_ranges(const json& rangesJson) {
+    std::vector<std::pair<double, double>> ranges;
+    for (auto& rangeJson : rangesJson) {
+        std::pair<double, double> range{rangeJson[0], rangeJson[1]};
+        ranges.push_back(range);
+    }
+    return ranges;
+}
 
-        json result;
-        to_json(result, coefficientsPerRange);
-        return result;
+std::vector<VolumetricLossesPoint> read_volumetric_losses_points(const json& dataJson) {
+    std::vector<VolumetricLossesPoint> data;
+    data.reserve(dataJson.size());
+    for (auto& datumJson : dataJson) {
+        VolumetricLossesPoint datum(datumJson);
+        data.push_back(datum);
+    }
+    return data;
+}
+
+json fit_steinmetz_coefficients(const json& dataJson, const json& rangesJson) {
+    auto ranges = read_steinmetz_ranges(rangesJson);
+    auto data = read_volumetric_losses_points(dataJson);
+
+    auto [coefficientsPerRange, errorPerRange] = OpenMagnetics::CoreLossesSteinmetzModel::calculate_steinmetz_coefficients(data, ranges);
+
+    json aux;
+    to_json(aux, coefficientsPerRange);
+    json result;
+    result["coefficientsPerRange"] = aux;
+    result["errorPerRange"] = errorPerRange;
+    return result;
+}
+
+} // namespace
+
+json calculate_steinmetz_coefficients(json dataJson, json rangesJson) {
+    try {
+        return fit_steinmetz_coefficients(dataJson, rangesJson)["coefficientsPerRange"];
     }
     catch (const std::exception &exc) {
         return "Exception: " + std::string{exc.what()};
@@ -103,25 +129,34 @@ json calculate_steinmetz_coefficients(json dataJson, json rangesJson) {
 
 json calculate_steinmetz_coefficients_with_error(json dataJson, json rangesJson) {
     try {
-        std::vector<std::pair<double, double>> ranges;
-        for (auto rangeJson : rangesJson) {
-            std::pair<double, double> range{rangeJson[0], rangeJson[1]};
-            ranges.push_back(range);
-        }
-        std::vector<VolumetricLossesPoint> data;
-        for (auto datumJson : dataJson) {
-            VolumetricLossesPoint datum(datumJson);
-            data.push_back(datum);
-        }
-
-        auto [coefficientsPerRange, errorPerRange] = OpenMagnetics::CoreLossesSteinmetzModel::calculate_steinmetz_coefficients(data, ranges);
+        return fit_steinmetz_coefficients(dataJson, rangesJson);
+    }
+    catch (const std::exception &exc) {
+        return "Exception: " + std::string{exc.what()};
+    }
+}
 
-        json aux;
-        to_json(aux, coefficientsPerRange);
-        json result;
-        result["coefficientsPerRange"] = aux;
-        result["errorPerRange"] = errorPerRange;
-        return result;
+// Each dataset is fitted on its own, so a failed fit only replaces that dataset's result
+json calculate_steinmetz_coefficients_batch(json datasetsJson) {
+    try {
+        if (!datasetsJson.is_array()) {
+            throw std::invalid_argument("Expected a list of {\"data\": [...], \"ranges\": [...]} datasets");
+        }
+        const json& datasets = datasetsJson;
+        std::vector<json> results(datasets.size());
+        parallel_for(datasets.size(), [&](size_t datasetIndex) {
+            auto& datasetJson = datasets[datasetIndex];
+            try {
+                results[datasetIndex] = fit_steinmetz_coefficients(datasetJson.at("data"), datasetJson.at("ranges"));
+                if (datasetJson.contains("name")) {
+                    results[datasetIndex]["name"] = datasetJson["name"];
+                }
+            }
+            catch (const std::exception &exc) {
+                results[datasetIndex] = "Exception: " + std::string{exc.what()};
+            }
+        });
+        return results;
     }
     catch (const std::exception &exc) {
         return "Exception: " + std::string{exc.what()};
@@ -130,6 +165,7 @@ json calculate_steinmetz_coefficients_with_error(json dataJson, json rangesJson)
 
 json calculate_winding_losses(json magneticJson, json operatingPointJson, double temperature) {
     try {
+        materialize_references(magneticJson, operatingPointJson);
         OpenMagnetics::Magnetic magnetic(magneticJson);
         OperatingPoint operatingPoint(operatingPointJson);
 
@@ -148,6 +184,7 @@ json calculate_winding_losses(json magneticJson, json operatingPointJson, double
 
 json calculate_ohmic_losses(json coilJson, json operatingPointJson, double temperature) {
     try {
+        materialize_references(coilJson, operatingPointJson);
         OpenMagnetics::Coil coil(coilJson, false);
         OperatingPoint operatingPoint(operatingPointJson);
 
@@ -166,6 +203,7 @@ json calculate_ohmic_losses(json coilJson, json operatingPointJson, double tempe
 
 json calculate_magnetic_field_strength_field(json operatingPointJson, json magneticJson) {
     try {
+        materialize_references(operatingPointJson, magneticJson);
         OpenMagnetics::Magnetic magnetic(magneticJson);
         OperatingPoint operatingPoint(operatingPointJson);
         OpenMagnetics::MagneticField magneticField;
@@ -185,6 +223,7 @@ json calculate_magnetic_field_strength_field(json operatingPointJson, json magne
 
 json calculate_proximity_effect_losses(json coilJson, double temperature, json windingLossesOutputJson, json windingWindowMagneticStrengthFieldOutputJson) {
     try {
+        materialize_references(coilJson, windingLossesOutputJson, windingWindowMagneticStrengthFieldOutputJson);
         OpenMagnetics::Coil coil(coilJson, false);
         WindingLossesOutput windingLossesOutput(windingLossesOutputJson);
         WindingWindowMagneticStrengthFieldOutput windingWindowMagneticStrengthFieldOutput(windingWindowMagneticStrengthFieldOutputJson);
@@ -204,6 +243,7 @@ json calculate_proximity_effect_losses(json coilJson, double temperature, json w
 
 json calculate_skin_effect_losses(json coilJson, json windingLossesOutputJson, double temperature) {
     try {
+        materialize_references(coilJson, windingLossesOutputJson);
         OpenMagnetics::Coil coil(coilJson, false);
         WindingLossesOutput windingLossesOutput(windingLossesOutputJson);
 
@@ -221,6 +261,7 @@ json calculate_skin_effect_losses(json coilJson, json windingLossesOutputJson, d
 
 json calculate_skin_effect_losses_per_meter(json wireJson, json currentJson, double temperature, double currentDivider) {
     try {
+        materialize_references(wireJson, currentJson);
         OpenMagnetics::Wire wire(wireJson);
         SignalDescriptor current(currentJson);
 
@@ -237,12 +278,14 @@ json calculate_skin_effect_losses_per_meter(json wireJson, json currentJson, dou
 }
 
 double calculate_dc_resistance_per_meter(json wireJson, double temperature) {
+    materialize_references(wireJson);
     OpenMagnetics::Wire wire(wireJson);
     auto dcResistancePerMeter = OpenMagnetics::WindingOhmicLosses::calculate_dc_resistance_per_meter(wire, temperature);
     return dcResistancePerMeter;
 }
 
 double calculate_dc_losses_per_meter(json wireJson, json currentJson, double temperature) {
+    materialize_references(wireJson, currentJson);
     OpenMagnetics::Wire wire(wireJson);
     SignalDescriptor current(currentJson);
     auto dcLossesPerMeter = OpenMagnetics::WindingOhmicLosses::calculate_ohmic_losses_per_meter(wire, current, temperature);
@@ -250,6 +293,7 @@ double calculate_dc_losses_per_meter(json wireJson, json currentJson, double tem
 }
 
 double calculate_skin_ac_factor(json wireJson, json currentJson, double temperature) {
+    materialize_references(wireJson, currentJson);
     OpenMagnetics::Wire wire(wireJson);
     SignalDescriptor current(currentJson);
     auto dcLossesPerMeter = OpenMagnetics::WindingOhmicLosses::calculate_ohmic_losses_per_meter(wire, current, temperature);
@@ -259,6 +303,7 @@ double calculate_skin_ac_factor(json wireJson, json currentJson, double temperat
 }
 
 double calculate_skin_ac_losses_per_meter(json wireJson, json currentJson, double temperature) {
+    materialize_references(wireJson, currentJson);
     OpenMagnetics::Wire wire(wireJson);
     SignalDescriptor current(currentJson);
     auto [skinLossesPerMeter, _] = OpenMagnetics::WindingSkinEffectLosses::calculate_skin_effect_losses_per_meter(wire, current, temperature);
@@ -266,6 +311,7 @@ double calculate_skin_ac_losses_per_meter(json wireJson, json currentJson, doubl
 }
 
 double calculate_skin_ac_resistance_per_meter(json wireJson, json currentJson, double temperature) {
+    materialize_references(wireJson, currentJson);
     OpenMagnetics::Wire wire(wireJson);
     SignalDescriptor current(currentJson);
     auto dcLossesPerMeter = OpenMagnetics::WindingOhmicLosses::calculate_ohmic_losses_per_meter(wire, current, temperature);
@@ -277,6 +323,7 @@ double calculate_skin_ac_resistance_per_meter(json wireJson, json currentJson, d
 }
 
 double calculate_effective_current_density(json wireJson, json currentJson, double temperature) {
+    materialize_references(wireJson, currentJson);
     OpenMagnetics::Wire wire(wireJson);
     SignalDescriptor current(currentJson);
     auto effectiveCurrentDensity = wire.calculate_effective_current_density(current, temperature);
@@ -286,6 +333,7 @@ double calculate_effective_current_density(json wireJson, json currentJson, doub
 
 double calculate_effective_skin_depth(std::string materialName, json currentJson, double temperature) {
     try {
+        materialize_record(materialName);
         SignalDescriptor current(currentJson);
 
         if (!current.get_processed()->get_effective_frequency()) {
@@ -308,6 +356,9 @@ void register_losses_bindings(py::module& m) {
     m.def("calculate_steinmetz_coefficients", &calculate_steinmetz_coefficients, "Calculate Steinmetz coefficients from loss data");
     m.def("calculate_steinmetz_coefficients_with_error", &calculate_steinmetz_coefficients_with_error,
         "Calculate Steinmetz coefficients with error estimation");
+    m.def("calculate_steinmetz_coefficients_batch", &calculate_steinmetz_coefficients_batch,
+        "Fit Steinmetz coefficients with error estimation for many {data, ranges} datasets in parallel, returning the result or the error message for each of them",
+        py::arg("datasets"), py::call_guard<py::gil_scoped_release>());
 
     // Winding losses
     m.def("calculate_winding_losses", &calculate_winding_losses, "Calculate total winding losses");
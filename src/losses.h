@@ -10,6 +10,7 @@ json get_core_losses_model_information(json material);
 json get_core_temperature_model_information();
 json calculate_steinmetz_coefficients(json dataJson, json rangesJson);
 json calculate_steinmetz_coefficients_with_error(json dataJson, json rangesJson);
+json calculate_steinmetz_coefficients_batch(json datasetsJson);
 
 // Winding losses
 json calculate_winding_losses(json magneticJson, json operatingPointJson, double temperature);
@@ -0,0 +1,137 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PyMKF {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open file " + path.string());
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot read size of file " + path.string());
+    }
+    _fileHandle = file;
+    _size = static_cast<size_t>(fileSize.QuadPart);
+    if (_size == 0) {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        release();
+        throw std::runtime_error("Cannot map file " + path.string());
+    }
+    _mappingHandle = mapping;
+    _data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (_data == nullptr) {
+        release();
+        throw std::runtime_error("Cannot map file " + path.string());
+    }
+}
+
+void MappedFile::release() {
+    if (_data != nullptr) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mappingHandle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(_mappingHandle));
+    }
+    if (_fileHandle != nullptr) {
+        CloseHandle(static_cast<HANDLE>(_fileHandle));
+    }
+    _data = nullptr;
+    _size = 0;
+    _mappingHandle = nullptr;
+    _fileHandle = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : _data(std::exchange(other._data, nullptr)),
+      _size(std::exchange(other._size, 0)),
+      _fileHandle(std::exchange(other._fileHandle, nullptr)),
+      _mappingHandle(std::exchange(other._mappingHandle, nullptr)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+        _fileHandle = std::exchange(other._fileHandle, nullptr);
+        _mappingHandle = std::exchange(other._mappingHandle, nullptr);
+    }
+    return *this;
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    int fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        throw std::runtime_error("Cannot open file " + path.string());
+    }
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0) {
+        close(fileDescriptor);
+        throw std::runtime_error("Cannot read size of file " + path.string());
+    }
+    _size = static_cast<size_t>(fileStatus.st_size);
+    if (_size > 0) {
+        void* mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (mapping == MAP_FAILED) {
+            close(fileDescriptor);
+            _size = 0;
+            throw std::runtime_error("Cannot map file " + path.string());
+        }
+        _data = static_cast<const char*>(mapping);
+    }
+    // The mapping keeps its own reference to the file
+    close(fileDescriptor);
+}
+
+void MappedFile::release() {
+    if (_data != nullptr) {
+        munmap(const_cast<char*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : _data(std::exchange(other._data, nullptr)),
+      _size(std::exchange(other._size, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+    }
+    return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+} // namespace PyMKF
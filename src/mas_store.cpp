@@ -0,0 +1,190 @@
+#include "mas_store.h"
+#include "memory_usage.h"
+#include "parallel.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace PyMKF {
+
+namespace {
+
+size_t estimate_mas_bytes(const std::string& key, const OpenMagnetics::Mas& mas) {
+    json serialized;
+    to_json(serialized, mas);
+    return estimate_json_bytes(serialized) + key.size();
+}
+
+} // namespace
+
+MasStore::MasStore(size_t numberShards) {
+    for (size_t shardIndex = 0; shardIndex < std::max<size_t>(numberShards, 1); ++shardIndex) {
+        _shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+MasStore::Shard& MasStore::get_shard(const std::string& key) const {
+    return *_shards[std::hash<std::string>{}(key) % _shards.size()];
+}
+
+size_t MasStore::get_shard_budget() const {
+    return _memoryBudget.load(std::memory_order_relaxed) / _shards.size();
+}
+
+void MasStore::store(Shard& shard, const std::string& key, std::shared_ptr<const OpenMagnetics::Mas> mas, size_t bytes) {
+    auto [it, inserted] = shard.entries.try_emplace(key);
+    auto& entry = it->second;
+    if (inserted) {
+        _size.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        shard.bytes -= entry.bytes;
+        _bytes.fetch_sub(entry.bytes, std::memory_order_relaxed);
+    }
+    entry.mas = std::move(mas);
+    entry.bytes = bytes;
+    entry.lastAccess.store(_clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    shard.bytes += bytes;
+    _bytes.fetch_add(bytes, std::memory_order_relaxed);
+    _insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t MasStore::insert(const std::string& key, OpenMagnetics::Mas mas) {
+    size_t bytes = estimate_mas_bytes(key, mas);
+    auto stored = std::make_shared<const OpenMagnetics::Mas>(std::move(mas));
+
+    auto& shard = get_shard(key);
+    std::unique_lock lock(shard.mutex);
+    store(shard, key, std::move(stored), bytes);
+    if (get_memory_budget() > 0 && shard.bytes > get_shard_budget()) {
+        evict(shard, &key);
+    }
+    return _size.load(std::memory_order_relaxed);
+}
+
+size_t MasStore::insert_many(std::vector<std::pair<std::string, OpenMagnetics::Mas>> items) {
+    std::vector<size_t> bytes(items.size());
+    parallel_for(items.size(), [&](size_t itemIndex) {
+        bytes[itemIndex] = estimate_mas_bytes(items[itemIndex].first, items[itemIndex].second);
+    });
+
+    std::vector<std::vector<size_t>> itemsByShard(_shards.size());
+    for (size_t itemIndex = 0; itemIndex < items.size(); ++itemIndex) {
+        itemsByShard[std::hash<std::string>{}(items[itemIndex].first) % _shards.size()].push_back(itemIndex);
+    }
+
+    for (size_t shardIndex = 0; shardIndex < _shards.size(); ++shardIndex) {
+        if (itemsByShard[shardIndex].empty()) {
+            continue;
+        }
+        auto& shard = *_shards[shardIndex];
+        std::unique_lock lock(shard.mutex);
+        for (auto itemIndex : itemsByShard[shardIndex]) {
+            auto& [key, mas] = items[itemIndex];
+            store(shard, key, std::make_shared<const OpenMagnetics::Mas>(std::move(mas)), bytes[itemIndex]);
+        }
+        if (get_memory_budget() > 0 && shard.bytes > get_shard_budget()) {
+            evict(shard, &items[itemsByShard[shardIndex].back()].first);
+        }
+    }
+    return _size.load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<const OpenMagnetics::Mas> MasStore::find(const std::string& key) const {
+    auto& shard = get_shard(key);
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        _misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    // Recency is an atomic stamp, so readers never need the exclusive lock
+    it->second.lastAccess.store(_clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _hits.fetch_add(1, std::memory_order_relaxed);
+    return it->second.mas;
+}
+
+bool MasStore::erase(const std::string& key) {
+    auto& shard = get_shard(key);
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    shard.bytes -= it->second.bytes;
+    _bytes.fetch_sub(it->second.bytes, std::memory_order_relaxed);
+    _size.fetch_sub(1, std::memory_order_relaxed);
+    shard.entries.erase(it);
+    return true;
+}
+
+void MasStore::clear() {
+    for (auto& shard : _shards) {
+        std::unique_lock lock(shard->mutex);
+        _bytes.fetch_sub(shard->bytes, std::memory_order_relaxed);
+        _size.fetch_sub(shard->entries.size(), std::memory_order_relaxed);
+        shard->entries.clear();
+        shard->bytes = 0;
+    }
+}
+
+size_t MasStore::size() const {
+    return _size.load(std::memory_order_relaxed);
+}
+
+void MasStore::set_memory_budget(size_t memoryBudget) {
+    _memoryBudget.store(memoryBudget, std::memory_order_relaxed);
+    if (memoryBudget == 0) {
+        return;
+    }
+    for (auto& shard : _shards) {
+        std::unique_lock lock(shard->mutex);
+        if (shard->bytes > get_shard_budget()) {
+            evict(*shard, nullptr);
+        }
+    }
+}
+
+size_t MasStore::get_memory_budget() const {
+    return _memoryBudget.load(std::memory_order_relaxed);
+}
+
+void MasStore::evict(Shard& shard, const std::string* keep) {
+    // Evict down to 7/8 of the budget so a full shard does not sort its entries on every insert
+    size_t target = get_shard_budget() - get_shard_budget() / 8;
+    std::vector<std::pair<uint64_t, const std::string*>> byAge;
+    byAge.reserve(shard.entries.size());
+    for (auto& [key, entry] : shard.entries) {
+        if (keep == nullptr || key != *keep) {
+            byAge.emplace_back(entry.lastAccess.load(std::memory_order_relaxed), &key);
+        }
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    for (auto& [lastAccess, key] : byAge) {
+        if (shard.bytes <= target) {
+            break;
+        }
+        auto it = shard.entries.find(*key);
+        shard.bytes -= it->second.bytes;
+        _bytes.fetch_sub(it->second.bytes, std::memory_order_relaxed);
+        _size.fetch_sub(1, std::memory_order_relaxed);
+        _evictions.fetch_add(1, std::memory_order_relaxed);
+        shard.entries.erase(it);
+    }
+}
+
+json MasStore::get_statistics() const {
+    json statistics;
+    statistics["objects"] = size();
+    statistics["bytes"] = _bytes.load(std::memory_order_relaxed);
+    statistics["memoryBudget"] = get_memory_budget();
+    statistics["shards"] = _shards.size();
+    statistics["hits"] = _hits.load(std::memory_order_relaxed);
+    statistics["misses"] = _misses.load(std::memory_order_relaxed);
+    statistics["insertions"] = _insertions.load(std::memory_order_relaxed);
+    statistics["evictions"] = _evictions.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+} // namespace PyMKF
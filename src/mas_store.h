@@ -0,0 +1,67 @@
+#pragma once
+
+#include "common.h"
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace PyMKF {
+
+// Thread-safe store of loaded MAS objects, split in shards by key hash. Lookups only take a
+// shared lock on one shard. With a memory budget set, each shard evicts its least recently read
+// objects once it goes over its share of the budget, always keeping the object just inserted.
+class MasStore {
+  public:
+    explicit MasStore(size_t numberShards = 16);
+
+    // Inserts or replaces the object under key and returns the number of stored objects
+    size_t insert(const std::string& key, OpenMagnetics::Mas mas);
+    // Same as inserting every item in order, but locks each shard only once
+    size_t insert_many(std::vector<std::pair<std::string, OpenMagnetics::Mas>> items);
+    // Returns nullptr when the key is not stored, or has been evicted
+    std::shared_ptr<const OpenMagnetics::Mas> find(const std::string& key) const;
+    bool erase(const std::string& key);
+    void clear();
+    size_t size() const;
+
+    // Estimated bytes of serialized MAS data to keep, 0 means unbounded
+    void set_memory_budget(size_t memoryBudget);
+    size_t get_memory_budget() const;
+    json get_statistics() const;
+
+  private:
+    struct Entry {
+        std::shared_ptr<const OpenMagnetics::Mas> mas;
+        size_t bytes = 0;
+        mutable std::atomic<uint64_t> lastAccess{0};
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        size_t bytes = 0;
+    };
+
+    Shard& get_shard(const std::string& key) const;
+    size_t get_shard_budget() const;
+    // Caller must hold the shard's exclusive lock
+    void store(Shard& shard, const std::string& key, std::shared_ptr<const OpenMagnetics::Mas> mas, size_t bytes);
+    // Caller must hold the shard's exclusive lock
+    void evict(Shard& shard, const std::string* keep);
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    std::atomic<size_t> _memoryBudget{0};
+    std::atomic<size_t> _bytes{0};
+    std::atomic<size_t> _size{0};
+    mutable std::atomic<uint64_t> _clock{0};
+    mutable std::atomic<uint64_t> _hits{0};
+    mutable std::atomic<uint64_t> _misses{0};
+    std::atomic<uint64_t> _insertions{0};
+    std::atomic<uint64_t> _evictions{0};
+};
+
+// Objects loaded through load_mas, load_magnetic and load_magnetics
+extern MasStore masDatabase;
+
+} // namespace PyMKF
@@ -0,0 +1,338 @@
+#include "material_surface.h"
+#include "database.h"
+#include "lazy_database.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+
+namespace PyMKF {
+
+namespace {
+
+std::mutex materialSurfacesMutex;
+bool materialSurfacesEnabled = false;
+MaterialSurfaceGrid materialSurfaceGrid;
+uint64_t materialSurfacesDatabaseVersion = 0;
+// Surfaces are built outside materialSurfacesMutex, callers asking for one under construction wait on its future
+using MaterialSurfaceFuture = std::shared_future<std::shared_ptr<const MaterialSurface>>;
+std::map<std::string, std::shared_ptr<const MaterialSurfaceFuture>> materialSurfaces;
+std::atomic<uint64_t> materialSurfaceHits{0};
+std::atomic<uint64_t> materialSurfaceMisses{0};
+
+MaterialSurfaceAxis read_axis(const json& gridJson, const std::string& name, MaterialSurfaceAxis axis) {
+    if (!gridJson.contains(name)) {
+        return axis;
+    }
+    auto& axisJson = gridJson.at(name);
+    axis.minimum = axisJson.value("minimum", axis.minimum);
+    axis.maximum = axisJson.value("maximum", axis.maximum);
+    axis.points = axisJson.value("points", axis.points);
+    if (axis.points < 2 || !(axis.minimum < axis.maximum)) {
+        throw std::invalid_argument(name + " needs at least 2 points and a minimum below its maximum");
+    }
+    if (axis.logarithmic && axis.minimum <= 0) {
+        throw std::invalid_argument(name + " is sampled logarithmically, its minimum must be positive");
+    }
+    return axis;
+}
+
+json axis_to_json(const MaterialSurfaceAxis& axis) {
+    json result;
+    result["minimum"] = axis.minimum;
+    result["maximum"] = axis.maximum;
+    result["points"] = axis.points;
+    result["logarithmic"] = axis.logarithmic;
+    return result;
+}
+
+json error_to_json(const MaterialSurface::Error& error, const std::string& exception, size_t points) {
+    json result;
+    if (!exception.empty()) {
+        result["available"] = false;
+        result["exception"] = exception;
+        return result;
+    }
+    result["available"] = true;
+    result["points"] = points;
+    result["maximumRelativeError"] = error.maximumRelativeError;
+    result["temperature"] = error.temperature;
+    result["magneticFieldDcBias"] = error.magneticFieldDcBias;
+    result["frequency"] = error.frequency;
+    return result;
+}
+
+void record_error(MaterialSurface::Error& error, double interpolated, double exact, double temperature, double magneticFieldDcBias, double frequency) {
+    if (exact == 0) {
+        return;
+    }
+    double relativeError = std::abs(interpolated - exact) / std::abs(exact);
+    if (relativeError > error.maximumRelativeError) {
+        error = {relativeError, temperature, magneticFieldDcBias, frequency};
+    }
+}
+
+} // namespace
+
+double MaterialSurfaceAxis::get_value(size_t index) const {
+    double position = static_cast<double>(index) / (points - 1);
+    if (logarithmic) {
+        return minimum * std::pow(maximum / minimum, position);
+    }
+    return minimum + (maximum - minimum) * position;
+}
+
+std::optional<std::pair<size_t, double>> MaterialSurfaceAxis::locate(double value) const {
+    // Also rejects NaN
+    if (!(value >= minimum && value <= maximum)) {
+        return std::nullopt;
+    }
+    double position = logarithmic ? std::log(value / minimum) / std::log(maximum / minimum) : (value - minimum) / (maximum - minimum);
+    position *= points - 1;
+    auto cell = std::min(static_cast<size_t>(position), points - 2);
+    return std::pair{cell, position - cell};
+}
+
+MaterialSurface::MaterialSurface(const json& materialName, const MaterialSurfaceGrid& grid) : _grid(grid) {
+    auto start = std::chrono::steady_clock::now();
+    materialize_references(materialName);
+    auto materialData = OpenMagnetics::find_core_material_by_name(materialName);
+    auto& temperatureAxis = _grid.temperature;
+    auto& magneticFieldDcBiasAxis = _grid.magneticFieldDcBias;
+    auto& frequencyAxis = _grid.frequency;
+
+    // A material missing the data for one property still gets a surface for the other
+    try {
+        OpenMagnetics::InitialPermeability initialPermeability;
+        _permeability.reserve(temperatureAxis.points * magneticFieldDcBiasAxis.points * frequencyAxis.points);
+        for (size_t t = 0; t < temperatureAxis.points; ++t) {
+            for (size_t h = 0; h < magneticFieldDcBiasAxis.points; ++h) {
+                for (size_t f = 0; f < frequencyAxis.points; ++f) {
+                    _permeability.push_back(initialPermeability.get_initial_permeability(materialData, temperatureAxis.get_value(t), magneticFieldDcBiasAxis.get_value(h), frequencyAxis.get_value(f)));
+                }
+            }
+        }
+        for (size_t t = 0; t + 1 < temperatureAxis.points; ++t) {
+            double temperature = (temperatureAxis.get_value(t) + temperatureAxis.get_value(t + 1)) / 2;
+            for (size_t h = 0; h + 1 < magneticFieldDcBiasAxis.points; ++h) {
+                double magneticFieldDcBias = (magneticFieldDcBiasAxis.get_value(h) + magneticFieldDcBiasAxis.get_value(h + 1)) / 2;
+                for (size_t f = 0; f + 1 < frequencyAxis.points; ++f) {
+                    double frequency = std::sqrt(frequencyAxis.get_value(f) * frequencyAxis.get_value(f + 1));
+                    double exact = initialPermeability.get_initial_permeability(materialData, temperature, magneticFieldDcBias, frequency);
+                    record_error(_permeabilityError, get_permeability(temperature, magneticFieldDcBias, frequency).value(), exact, temperature, magneticFieldDcBias, frequency);
+                }
+            }
+        }
+    }
+    catch (const std::exception &exc) {
+        _permeability.clear();
+        _permeabilityException = exc.what();
+    }
+
+    try {
+        auto resistivityModel = OpenMagnetics::ResistivityModel::factory(OpenMagnetics::ResistivityModels::CORE_MATERIAL);
+        _resistivity.reserve(temperatureAxis.points);
+        for (size_t t = 0; t < temperatureAxis.points; ++t) {
+            _resistivity.push_back((*resistivityModel).get_resistivity(materialData, temperatureAxis.get_value(t)));
+        }
+        for (size_t t = 0; t + 1 < temperatureAxis.points; ++t) {
+            double temperature = (temperatureAxis.get_value(t) + temperatureAxis.get_value(t + 1)) / 2;
+            double exact = (*resistivityModel).get_resistivity(materialData, temperature);
+            record_error(_resistivityError, get_resistivity(temperature).value(), exact, temperature, 0, 0);
+        }
+    }
+    catch (const std::exception &exc) {
+        _resistivity.clear();
+        _resistivityException = exc.what();
+    }
+    _buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::optional<double> MaterialSurface::get_permeability(double temperature, double magneticFieldDcBias, double frequency) const {
+    if (_permeability.empty()) {
+        return std::nullopt;
+    }
+    auto t = _grid.temperature.locate(temperature);
+    auto h = _grid.magneticFieldDcBias.locate(magneticFieldDcBias);
+    auto f = _grid.frequency.locate(frequency);
+    if (!t || !h || !f) {
+        return std::nullopt;
+    }
+    auto [t0, tw] = *t;
+    auto [h0, hw] = *h;
+    auto [f0, fw] = *f;
+    size_t frequencyStride = 1;
+    size_t magneticFieldDcBiasStride = _grid.frequency.points;
+    size_t temperatureStride = _grid.magneticFieldDcBias.points * magneticFieldDcBiasStride;
+    const double* corner = _permeability.data() + t0 * temperatureStride + h0 * magneticFieldDcBiasStride + f0 * frequencyStride;
+    auto along_frequency = [&](const double* values) {
+        return values[0] + fw * (values[frequencyStride] - values[0]);
+    };
+    auto along_magnetic_field_dc_bias = [&](const double* values) {
+        double low = along_frequency(values);
+        return low + hw * (along_frequency(values + magneticFieldDcBiasStride) - low);
+    };
+    double low = along_magnetic_field_dc_bias(corner);
+    return low + tw * (along_magnetic_field_dc_bias(corner + temperatureStride) - low);
+}
+
+std::optional<double> MaterialSurface::get_resistivity(double temperature) const {
+    if (_resistivity.empty()) {
+        return std::nullopt;
+    }
+    auto t = _grid.temperature.locate(temperature);
+    if (!t) {
+        return std::nullopt;
+    }
+    auto [t0, tw] = *t;
+    return _resistivity[t0] + tw * (_resistivity[t0 + 1] - _resistivity[t0]);
+}
+
+json MaterialSurface::get_steinmetz_coefficients(const json& materialName, double frequency) const {
+    {
+        std::lock_guard<std::mutex> lock(_steinmetzMutex);
+        for (auto& range : _steinmetzRanges) {
+            if (range.minimumFrequency < frequency && frequency < range.maximumFrequency) {
+                return range.coefficients;
+            }
+        }
+    }
+    auto steinmetzCoreLossesMethodRangeDatum = OpenMagnetics::CoreLossesModel::get_steinmetz_coefficients(materialName, frequency);
+    json result;
+    to_json(result, steinmetzCoreLossesMethodRangeDatum);
+    // Only a range that really holds the frequency can answer for its neighbours. Ranges of one
+    // material do not overlap in MAS, so the first one holding a frequency is the one the model picks.
+    if (!result.contains("minimumFrequency") || !result["minimumFrequency"].is_number() ||
+        !result.contains("maximumFrequency") || !result["maximumFrequency"].is_number()) {
+        return result;
+    }
+    double minimumFrequency = result["minimumFrequency"];
+    double maximumFrequency = result["maximumFrequency"];
+    if (minimumFrequency < frequency && frequency < maximumFrequency) {
+        std::lock_guard<std::mutex> lock(_steinmetzMutex);
+        bool known = std::any_of(_steinmetzRanges.begin(), _steinmetzRanges.end(), [&](const SteinmetzRange& range) {
+            return range.minimumFrequency < frequency && frequency < range.maximumFrequency;
+        });
+        if (!known) {
+            _steinmetzRanges.push_back({minimumFrequency, maximumFrequency, result});
+        }
+    }
+    return result;
+}
+
+json MaterialSurface::get_statistics() const {
+    json statistics;
+    statistics["buildSeconds"] = _buildSeconds;
+    statistics["permeability"] = error_to_json(_permeabilityError, _permeabilityException, _permeability.size());
+    auto resistivity = error_to_json(_resistivityError, _resistivityException, _resistivity.size());
+    resistivity.erase("magneticFieldDcBias");
+    resistivity.erase("frequency");
+    statistics["resistivity"] = resistivity;
+    std::lock_guard<std::mutex> lock(_steinmetzMutex);
+    statistics["steinmetzRanges"] = _steinmetzRanges.size();
+    return statistics;
+}
+
+std::shared_ptr<const MaterialSurface> get_material_surface(const json& materialName) {
+    if (!materialName.is_string()) {
+        return nullptr;
+    }
+    auto name = materialName.get<std::string>();
+    std::promise<std::shared_ptr<const MaterialSurface>> promise;
+    std::shared_ptr<const MaterialSurfaceFuture> surface;
+    MaterialSurfaceGrid grid;
+    bool isBuilder = false;
+    {
+        std::lock_guard<std::mutex> lock(materialSurfacesMutex);
+        if (!materialSurfacesEnabled) {
+            return nullptr;
+        }
+        // Material data may have changed under a reload
+        if (materialSurfacesDatabaseVersion != get_database_version()) {
+            materialSurfaces.clear();
+            materialSurfacesDatabaseVersion = get_database_version();
+        }
+        auto it = materialSurfaces.find(name);
+        if (it != materialSurfaces.end()) {
+            surface = it->second;
+        }
+        else {
+            surface = std::make_shared<const MaterialSurfaceFuture>(promise.get_future().share());
+            materialSurfaces.emplace(name, surface);
+            grid = materialSurfaceGrid;
+            isBuilder = true;
+        }
+    }
+    if (!isBuilder) {
+        return surface->get();
+    }
+
+    // This caller builds the surface, without holding up queries on other materials meanwhile
+    try {
+        promise.set_value(std::make_shared<const MaterialSurface>(materialName, grid));
+    }
+    catch (...) {
+        // Not cached, so the next query tries again, and statistics never see the failed entry
+        {
+            std::lock_guard<std::mutex> lock(materialSurfacesMutex);
+            auto it = materialSurfaces.find(name);
+            if (it != materialSurfaces.end() && it->second == surface) {
+                materialSurfaces.erase(it);
+            }
+        }
+        promise.set_exception(std::current_exception());
+    }
+    return surface->get();
+}
+
+void record_material_surface_queries(size_t hits, size_t misses) {
+    materialSurfaceHits += hits;
+    materialSurfaceMisses += misses;
+}
+
+std::string set_material_surface_cache(bool enabled, json gridJson) {
+    try {
+        MaterialSurfaceGrid grid;
+        grid.temperature = read_axis(gridJson, "temperature", grid.temperature);
+        grid.magneticFieldDcBias = read_axis(gridJson, "magneticFieldDcBias", grid.magneticFieldDcBias);
+        grid.frequency = read_axis(gridJson, "frequency", grid.frequency);
+        std::lock_guard<std::mutex> lock(materialSurfacesMutex);
+        materialSurfacesEnabled = enabled;
+        materialSurfaceGrid = grid;
+        materialSurfaces.clear();
+        return "0";
+    }
+    catch (const std::exception &exc) {
+        return "Exception: " + std::string{exc.what()};
+    }
+}
+
+std::string clear_material_surface_cache() {
+    std::lock_guard<std::mutex> lock(materialSurfacesMutex);
+    materialSurfaces.clear();
+    materialSurfaceHits = 0;
+    materialSurfaceMisses = 0;
+    return "0";
+}
+
+json get_material_surface_cache_statistics() {
+    std::lock_guard<std::mutex> lock(materialSurfacesMutex);
+    json statistics;
+    statistics["enabled"] = materialSurfacesEnabled;
+    statistics["grid"]["temperature"] = axis_to_json(materialSurfaceGrid.temperature);
+    statistics["grid"]["magneticFieldDcBias"] = axis_to_json(materialSurfaceGrid.magneticFieldDcBias);
+    statistics["grid"]["frequency"] = axis_to_json(materialSurfaceGrid.frequency);
+    statistics["hits"] = materialSurfaceHits.load();
+    statistics["misses"] = materialSurfaceMisses.load();
+    statistics["materials"] = json::object();
+    for (auto& [name, surface] : materialSurfaces) {
+        // Surfaces still being built are left out rather than waited for
+        if (surface->wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            statistics["materials"][name] = surface->get()->get_statistics();
+        }
+    }
+    return statistics;
+}
+
+} // namespace PyMKF
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "common.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace PyMKF {
+
+// Opt-in cache of core material properties. Each material is sampled once on a grid of
+// temperature, DC bias and frequency, and later permeability and resistivity queries inside the
+// grid are answered by interpolating between the samples. Queries outside the grid, or for
+// materials given inline instead of by name, still go to the exact model.
+//
+// Frequency is sampled logarithmically, the other two axes linearly. After sampling, the model is
+// evaluated again at the center of every cell, where trilinear interpolation is least accurate,
+// and the largest relative difference is reported as the interpolation error of the surface.
+
+struct MaterialSurfaceAxis {
+    double minimum;
+    double maximum;
+    size_t points;
+    bool logarithmic = false;
+
+    double get_value(size_t index) const;
+    // Index of the cell holding value and the position inside it, from 0 to 1
+    std::optional<std::pair<size_t, double>> locate(double value) const;
+};
+
+struct MaterialSurfaceGrid {
+    MaterialSurfaceAxis temperature{-40, 200, 25};
+    MaterialSurfaceAxis magneticFieldDcBias{0, 4000, 41};
+    MaterialSurfaceAxis frequency{1e3, 1e7, 41, true};
+};
+
+class MaterialSurface {
+  public:
+    struct Error {
+        double maximumRelativeError = 0;
+        double temperature = 0;
+        double magneticFieldDcBias = 0;
+        double frequency = 0;
+    };
+
+    MaterialSurface(const json& materialName, const MaterialSurfaceGrid& grid);
+
+    std::optional<double> get_permeability(double temperature, double magneticFieldDcBias, double frequency) const;
+    std::optional<double> get_resistivity(double temperature) const;
+    // Steinmetz coefficients are piecewise constant over frequency ranges, so each range the model
+    // returns is kept once and answers later frequencies strictly inside it. Frequencies on a range
+    // boundary or outside every range go to the model each time.
+    json get_steinmetz_coefficients(const json& materialName, double frequency) const;
+
+    json get_statistics() const;
+
+  private:
+    MaterialSurfaceGrid _grid;
+    // Indexed [temperature][dc bias][frequency], frequency innermost
+    std::vector<double> _permeability;
+    std::vector<double> _resistivity;
+    Error _permeabilityError;
+    Error _resistivityError;
+    std::string _permeabilityException;
+    std::string _resistivityException;
+    double _buildSeconds = 0;
+    struct SteinmetzRange {
+        double minimumFrequency;
+        double maximumFrequency;
+        json coefficients;
+    };
+    mutable std::mutex _steinmetzMutex;
+    // At most one entry per Steinmetz range of the material
+    mutable std::vector<SteinmetzRange> _steinmetzRanges;
+};
+
+// Surface of the named material, built on first use, or nullptr when the cache is disabled or
+// the material is not given by name
+std::shared_ptr<const MaterialSurface> get_material_surface(const json& materialName);
+// Counts queries answered by a surface and queries that fell back to the exact model
+void record_material_surface_queries(size_t hits, size_t misses);
+
+// Enables the cache with the given grid, as {"temperature": {"minimum", "maximum", "points"},
+// "magneticFieldDcBias": {...}, "frequency": {...}}, each axis optional. Changing the grid drops
+// the surfaces already built.
+std::string set_material_surface_cache(bool enabled, json gridJson);
+std::string clear_material_surface_cache();
+json get_material_surface_cache_statistics();
+
+} // namespace PyMKF
@@ -0,0 +1,116 @@
+#include "memory_usage.h"
+#include "mas_store.h"
+#include "parallel.h"
+#include "string_pool.h"
+#include <fstream>
+#include <numeric>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace PyMKF {
+
+namespace {
+
+template<typename Record>
+size_t estimate_record_bytes(const Record& record) {
+    json serialized;
+    to_json(serialized, record);
+    return estimate_json_bytes(serialized);
+}
+
+// Records are serialized to be measured, which is the slow part, so it is spread over threads
+template<typename Records>
+json get_records_usage(const Records& records) {
+    std::vector<const typename Records::value_type*> pointers;
+    pointers.reserve(records.size());
+    for (auto& record : records) {
+        pointers.push_back(&record);
+    }
+    std::vector<size_t> bytes(pointers.size());
+    parallel_for(pointers.size(), [&](size_t recordIndex) {
+        auto& record = *pointers[recordIndex];
+        if constexpr (requires (const typename Records::value_type& item) { item.second; }) {
+            bytes[recordIndex] = record.first.size() + estimate_record_bytes(record.second);
+        }
+        else {
+            bytes[recordIndex] = estimate_record_bytes(record);
+        }
+    });
+    json usage;
+    usage["records"] = records.size();
+    usage["bytes"] = std::accumulate(bytes.begin(), bytes.end(), size_t{0});
+    return usage;
+}
+
+std::optional<size_t> get_process_resident_bytes() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages, residentPages;
+    if (statm >> totalPages >> residentPages) {
+        return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return std::nullopt;
+}
+
+} // namespace
+
+size_t estimate_json_bytes(const json& document) {
+    switch (document.type()) {
+        case json::value_t::object: {
+            size_t bytes = sizeof(json);
+            for (auto& [key, value] : document.items()) {
+                bytes += key.size() + 32 + estimate_json_bytes(value);
+            }
+            return bytes;
+        }
+        case json::value_t::array: {
+            size_t bytes = sizeof(json);
+            for (auto& value : document) {
+                bytes += estimate_json_bytes(value);
+            }
+            return bytes;
+        }
+        case json::value_t::string:
+            return sizeof(json) + document.get_ref<const std::string&>().size();
+        default:
+            return sizeof(json);
+    }
+}
+
+json get_memory_usage() {
+    try {
+        json usage;
+        usage["coreMaterials"] = get_records_usage(OpenMagnetics::coreMaterialDatabase);
+        usage["coreShapes"] = get_records_usage(OpenMagnetics::coreShapeDatabase);
+        usage["wires"] = get_records_usage(OpenMagnetics::wireDatabase);
+        usage["bobbins"] = get_records_usage(OpenMagnetics::bobbinDatabase);
+        usage["insulationMaterials"] = get_records_usage(OpenMagnetics::insulationMaterialDatabase);
+        usage["wireMaterials"] = get_records_usage(OpenMagnetics::wireMaterialDatabase);
+        usage["cores"] = get_records_usage(OpenMagnetics::coreDatabase);
+        usage["magneticsCache"] = get_records_usage(OpenMagnetics::magneticsCache.get());
+
+        auto masStatistics = masDatabase.get_statistics();
+        usage["masDatabase"]["records"] = masStatistics["objects"];
+        usage["masDatabase"]["bytes"] = masStatistics["bytes"];
+        usage["stringPool"] = stringPool.get_statistics();
+
+        size_t totalBytes = 0;
+        for (auto& [name, entry] : usage.items()) {
+            totalBytes += entry["bytes"].get<size_t>();
+        }
+        usage["totalBytes"] = totalBytes;
+        if (auto residentBytes = get_process_resident_bytes()) {
+            usage["processResidentBytes"] = residentBytes.value();
+        }
+        return usage;
+    }
+    catch (const std::exception &exc) {
+        json exception;
+        exception["data"] = "Exception: " + std::string{exc.what()};
+        return exception;
+    }
+}
+
+} // namespace PyMKF
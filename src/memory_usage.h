@@ -0,0 +1,14 @@
+#pragma once
+
+#include "common.h"
+
+namespace PyMKF {
+
+// Rough in-memory footprint of a document, walked without serializing it to text
+size_t estimate_json_bytes(const json& document);
+
+// Estimated bytes held by every database, masDatabase, magneticsCache and the string pool, with
+// the resident size of the whole process where the platform reports it
+json get_memory_usage();
+
+} // namespace PyMKF
@@ -0,0 +1,188 @@
+#include "ndjson.h"
+
+namespace PyMKF {
+
+namespace {
+
+// SAX handler that only keeps the top-level "name" string and "aliases" strings
+class RecordNamesHandler : public nlohmann::json_sax<json> {
+  public:
+    explicit RecordNamesHandler(NdjsonRecordNames& names) : _names(names) {}
+
+    bool null() override { return value_done(); }
+    bool boolean(bool) override { return value_done(); }
+    bool number_integer(number_integer_t) override { return value_done(); }
+    bool number_unsigned(number_unsigned_t) override { return value_done(); }
+    bool number_float(number_float_t, const string_t&) override { return value_done(); }
+    bool binary(binary_t&) override { return value_done(); }
+
+    bool string(string_t& value) override {
+        if (_depth == 1 && _currentKey == "name") {
+            _names.name = value;
+        }
+        else if (_depth == 2 && _insideAliases) {
+            _names.aliases.push_back(value);
+        }
+        return value_done();
+    }
+
+    bool start_object(std::size_t) override {
+        _depth++;
+        return true;
+    }
+
+    bool end_object() override {
+        _depth--;
+        return value_done();
+    }
+
+    bool start_array(std::size_t) override {
+        _depth++;
+        if (_depth == 2 && _currentKey == "aliases") {
+            _insideAliases = true;
+        }
+        return true;
+    }
+
+    bool end_array() override {
+        if (_depth == 2) {
+            _insideAliases = false;
+        }
+        _depth--;
+        return value_done();
+    }
+
+    bool key(string_t& value) override {
+        if (_depth == 1) {
+            _currentKey = value;
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& exc) override {
+        throw std::runtime_error("Malformed ndjson record at byte " + std::to_string(position) + ": " + exc.what());
+    }
+
+  private:
+    bool value_done() {
+        if (_depth == 1) {
+            _currentKey.clear();
+        }
+        return true;
+    }
+
+    NdjsonRecordNames& _names;
+    std::string _currentKey;
+    size_t _depth = 0;
+    bool _insideAliases = false;
+};
+
+template <typename Database>
+void insert_record(Database& database, const std::string& key, const json& recordJson) {
+    using Record = typename Database::mapped_type;
+    Record record(recordJson);
+    database.insert_or_assign(key, record);
+}
+
+} // namespace
+
+std::vector<std::pair<size_t, size_t>> split_ndjson_lines(std::string_view text, size_t targetSize) {
+    std::vector<std::pair<size_t, size_t>> pieces;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = std::min(begin + targetSize, text.size());
+        if (end < text.size()) {
+            auto newline = text.find('\n', end);
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+        pieces.emplace_back(begin, end);
+        begin = end;
+    }
+    return pieces;
+}
+
+void for_each_ndjson_line(std::string_view text, const std::function<void(std::string_view)>& lineCallback) {
+    size_t begin = 0;
+    while (begin < text.size()) {
+        auto newline = text.find('\n', begin);
+        size_t end = newline == std::string_view::npos ? text.size() : newline;
+        auto line = text.substr(begin, end - begin);
+        if (line.find_first_not_of(" \t\r") != std::string_view::npos) {
+            lineCallback(line);
+        }
+        begin = end + 1;
+    }
+}
+
+uint64_t hash_text(std::string_view text, uint64_t hash) {
+    for (unsigned char character : text) {
+        hash ^= character;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::vector<NdjsonRecord> parse_ndjson_records(std::string_view text) {
+    std::vector<NdjsonRecord> records;
+    for_each_ndjson_line(text, [&](std::string_view line) {
+        records.push_back({json::parse(line), hash_text(line)});
+    });
+    return records;
+}
+
+NdjsonRecordNames scan_ndjson_record_names(std::string_view line) {
+    NdjsonRecordNames names;
+    RecordNamesHandler handler(names);
+    json::sax_parse(line.begin(), line.end(), &handler);
+    if (names.name.empty()) {
+        throw std::runtime_error("ndjson record without name: " + std::string(line.substr(0, 80)));
+    }
+    return names;
+}
+
+void insert_database_record(size_t sectionIndex, const std::string& key, const json& recordJson) {
+    switch (sectionIndex) {
+        case 0: insert_record(OpenMagnetics::coreMaterialDatabase, key, recordJson); break;
+        case 1: insert_record(OpenMagnetics::coreShapeDatabase, key, recordJson); break;
+        case 2: insert_record(OpenMagnetics::wireDatabase, key, recordJson); break;
+        case 3: insert_record(OpenMagnetics::bobbinDatabase, key, recordJson); break;
+        case 4: insert_record(OpenMagnetics::insulationMaterialDatabase, key, recordJson); break;
+        case 5: insert_record(OpenMagnetics::wireMaterialDatabase, key, recordJson); break;
+    }
+}
+
+DatabaseRecord build_database_record(size_t sectionIndex, const json& recordJson) {
+    switch (sectionIndex) {
+        case 0: return DatabaseRecord(std::in_place_index<0>, recordJson);
+        case 1: return DatabaseRecord(std::in_place_index<1>, recordJson);
+        case 2: return DatabaseRecord(std::in_place_index<2>, recordJson);
+        case 3: return DatabaseRecord(std::in_place_index<3>, recordJson);
+        case 4: return DatabaseRecord(std::in_place_index<4>, recordJson);
+        case 5: return DatabaseRecord(std::in_place_index<5>, recordJson);
+    }
+    throw std::invalid_argument("Unknown database section " + std::to_string(sectionIndex));
+}
+
+void insert_database_record(const std::string& key, DatabaseRecord record) {
+    switch (record.index()) {
+        case 0: OpenMagnetics::coreMaterialDatabase.insert_or_assign(key, std::move(std::get<0>(record))); break;
+        case 1: OpenMagnetics::coreShapeDatabase.insert_or_assign(key, std::move(std::get<1>(record))); break;
+        case 2: OpenMagnetics::wireDatabase.insert_or_assign(key, std::move(std::get<2>(record))); break;
+        case 3: OpenMagnetics::bobbinDatabase.insert_or_assign(key, std::move(std::get<3>(record))); break;
+        case 4: OpenMagnetics::insulationMaterialDatabase.insert_or_assign(key, std::move(std::get<4>(record))); break;
+        case 5: OpenMagnetics::wireMaterialDatabase.insert_or_assign(key, std::move(std::get<5>(record))); break;
+    }
+}
+
+void erase_database_record(size_t sectionIndex, const std::string& key) {
+    switch (sectionIndex) {
+        case 0: OpenMagnetics::coreMaterialDatabase.erase(key); break;
+        case 1: OpenMagnetics::coreShapeDatabase.erase(key); break;
+        case 2: OpenMagnetics::wireDatabase.erase(key); break;
+        case 3: OpenMagnetics::bobbinDatabase.erase(key); break;
+        case 4: OpenMagnetics::insulationMaterialDatabase.erase(key); break;
+        case 5: OpenMagnetics::wireMaterialDatabase.erase(key); break;
+    }
+}
+
+} // namespace PyMKF
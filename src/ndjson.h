@@ -0,0 +1,60 @@
+#pragma once
+
+#include "common.h"
+
+#include <string_view>
+#include <variant>
+
+namespace PyMKF {
+
+// Database sections in load order, with the ndjson file that holds each of them in a MAS data folder
+const std::vector<std::pair<std::string, std::string>> ndjsonDatabaseFiles = {
+    {"coreMaterials", "core_materials.ndjson"},
+    {"coreShapes", "core_shapes.ndjson"},
+    {"wires", "wires.ndjson"},
+    {"bobbins", "bobbins.ndjson"},
+    {"insulationMaterials", "insulation_materials.ndjson"},
+    {"wireMaterials", "wire_materials.ndjson"},
+};
+
+// Splits text into [begin, end) pieces of roughly targetSize bytes, each ending right after a newline
+std::vector<std::pair<size_t, size_t>> split_ndjson_lines(std::string_view text, size_t targetSize);
+
+// Calls lineCallback for every non-blank line of text, without the line terminator
+void for_each_ndjson_line(std::string_view text, const std::function<void(std::string_view)>& lineCallback);
+
+// FNV-1a, stable across platforms and runs unlike std::hash
+uint64_t hash_text(std::string_view text, uint64_t hash = 14695981039346656037ull);
+
+// Parsed record together with the hash of its raw line, so changed records can be told apart
+// without comparing documents
+struct NdjsonRecord {
+    json document;
+    uint64_t lineHash;
+};
+std::vector<NdjsonRecord> parse_ndjson_records(std::string_view text);
+
+// Top-level "name" and "aliases" of an ndjson record, extracted without building the document
+struct NdjsonRecordNames {
+    std::string name;
+    std::vector<std::string> aliases;
+};
+NdjsonRecordNames scan_ndjson_record_names(std::string_view line);
+
+// Inserts, replaces or removes a record of the OpenMagnetics database holding ndjsonDatabaseFiles[sectionIndex]
+void insert_database_record(size_t sectionIndex, const std::string& key, const json& recordJson);
+void erase_database_record(size_t sectionIndex, const std::string& key);
+
+// A record already built into its MKF object, its alternative index being its section index, so that
+// putting it in its database has nothing left that can fail on bad data
+using DatabaseRecord = std::variant<
+    decltype(OpenMagnetics::coreMaterialDatabase)::mapped_type,
+    decltype(OpenMagnetics::coreShapeDatabase)::mapped_type,
+    decltype(OpenMagnetics::wireDatabase)::mapped_type,
+    decltype(OpenMagnetics::bobbinDatabase)::mapped_type,
+    decltype(OpenMagnetics::insulationMaterialDatabase)::mapped_type,
+    decltype(OpenMagnetics::wireMaterialDatabase)::mapped_type>;
+DatabaseRecord build_database_record(size_t sectionIndex, const json& recordJson);
+void insert_database_record(const std::string& key, DatabaseRecord record);
+
+} // namespace PyMKF
@@ -0,0 +1,168 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace PyMKF {
+
+namespace {
+
+std::atomic<size_t> configuredNumberThreads{0};
+
+struct ParallelJob {
+    const std::function<void(size_t)>* task;
+    size_t numberTasks;
+    std::atomic<size_t> nextIndex{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr firstException;
+    std::mutex exceptionMutex;
+    // Pool workers currently inside run_job, guarded by the pool mutex
+    size_t numberHelpers = 0;
+    std::condition_variable helpersDone;
+};
+
+void run_job(ParallelJob& job) {
+    while (!job.failed.load(std::memory_order_relaxed)) {
+        size_t index = job.nextIndex.fetch_add(1);
+        if (index >= job.numberTasks) {
+            break;
+        }
+        try {
+            (*job.task)(index);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(job.exceptionMutex);
+            if (!job.firstException) {
+                job.firstException = std::current_exception();
+            }
+            job.failed.store(true);
+        }
+    }
+}
+
+// Set on pool workers, so a task that calls parallel_for runs it inline instead of waiting on
+// workers that may all be busy with the outer loop
+thread_local bool isPoolWorker = false;
+
+// Workers are started on first use and grown to the largest thread count asked for, then kept for
+// the life of the process. Each parallel_for queues one entry per helper it wants; workers take
+// entries in order, so concurrent calls from several Python threads share the pool fairly.
+class WorkerPool {
+  public:
+    explicit WorkerPool(int processId) : _processId(processId) {}
+
+    int get_owner_process_id() const {
+        return _processId;
+    }
+
+    void run(ParallelJob& job, size_t numberHelpers) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            while (_workers.size() < numberHelpers) {
+                _workers.emplace_back([this]() { work(); });
+            }
+            for (size_t helperIndex = 0; helperIndex < numberHelpers; ++helperIndex) {
+                _entries.push_back(&job);
+            }
+        }
+        _entryAvailable.notify_all();
+
+        // The calling thread works too instead of idling while the helpers finish
+        run_job(job);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        // Entries no worker picked up yet have nothing left to do
+        _entries.erase(std::remove(_entries.begin(), _entries.end(), &job), _entries.end());
+        job.helpersDone.wait(lock, [&] { return job.numberHelpers == 0; });
+    }
+
+  private:
+    void work() {
+        isPoolWorker = true;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _entryAvailable.wait(lock, [&] { return !_entries.empty(); });
+            ParallelJob* job = _entries.front();
+            _entries.pop_front();
+            job->numberHelpers++;
+            lock.unlock();
+            run_job(*job);
+            lock.lock();
+            if (--job->numberHelpers == 0) {
+                job->helpersDone.notify_all();
+            }
+        }
+    }
+
+    int _processId;
+    std::mutex _mutex;
+    std::condition_variable _entryAvailable;
+    std::deque<ParallelJob*> _entries;
+    std::vector<std::thread> _workers;
+};
+
+std::mutex poolMutex;
+// Never destroyed: workers block on the pool until the process exits
+WorkerPool* pool = nullptr;
+
+WorkerPool& get_pool() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    // A forked child inherits the pool but none of its threads, so it starts a pool of its own
+    if (pool == nullptr || pool->get_owner_process_id() != get_process_id()) {
+        pool = new WorkerPool(get_process_id());
+    }
+    return *pool;
+}
+
+} // namespace
+
+int get_process_id() {
+#ifdef _WIN32
+    return _getpid();
+#else
+    return getpid();
+#endif
+}
+
+size_t get_number_threads() {
+    size_t numberThreads = configuredNumberThreads.load();
+    if (numberThreads == 0) {
+        numberThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    return numberThreads;
+}
+
+void set_number_threads(size_t numberThreads) {
+    configuredNumberThreads.store(numberThreads);
+}
+
+void parallel_for(size_t numberTasks, const std::function<void(size_t)>& task) {
+    size_t numberWorkers = std::min(get_number_threads(), numberTasks);
+    if (numberWorkers <= 1 || isPoolWorker) {
+        for (size_t index = 0; index < numberTasks; ++index) {
+            task(index);
+        }
+        return;
+    }
+
+    ParallelJob job;
+    job.task = &task;
+    job.numberTasks = numberTasks;
+    get_pool().run(job, numberWorkers - 1);
+
+    if (job.firstException) {
+        std::rethrow_exception(job.firstException);
+    }
+}
+
+} // namespace PyMKF
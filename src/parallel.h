@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+namespace PyMKF {
+
+// Number of worker threads used by the parallel helpers (0 means hardware concurrency)
+size_t get_number_threads();
+void set_number_threads(size_t numberThreads);
+
+// Identifies this process among workers sharing files, and tells a forked child from its parent
+int get_process_id();
+
+// Runs task(index) for every index in [0, numberTasks) on up to get_number_threads() threads.
+// Indexes are handed out dynamically, so uneven tasks balance out. The first exception thrown
+// by a task is rethrown in the caller once all workers have stopped.
+void parallel_for(size_t numberTasks, const std::function<void(size_t)>& task);
+
+// Fixed-capacity queue between pipeline stages. push blocks while the queue is full and pop while
+// it is empty. Once closed, push refuses new items and pop drains what is left, then returns nullopt.
+template <typename T>
+class BoundedQueue {
+  public:
+    explicit BoundedQueue(size_t capacity) : _capacity(capacity > 0 ? capacity : 1) {}
+
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _notFull.wait(lock, [&] { return _closed || _items.size() < _capacity; });
+        if (_closed) {
+            return false;
+        }
+        _items.push_back(std::move(item));
+        _notEmpty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _notEmpty.wait(lock, [&] { return _closed || !_items.empty(); });
+        if (_items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(_items.front());
+        _items.pop_front();
+        _notFull.notify_one();
+        return item;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+        _notEmpty.notify_all();
+        _notFull.notify_all();
+    }
+
+  private:
+    size_t _capacity;
+    std::deque<T> _items;
+    bool _closed = false;
+    std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+};
+
+} // namespace PyMKF
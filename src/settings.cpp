@@ -1,4 +1,5 @@
 #include "settings.h"
+#include "parallel.h"
 
 namespace PyMKF {
 
@@ -255,6 +256,23 @@ void register_settings_bindings(py::module& m) {
         Returns:
             JSON object mapping model types to default model names.
         )pbdoc");
+
+    m.def("get_number_threads", &get_number_threads,
+        R"pbdoc(
+        Get the number of worker threads used by parallel operations.
+
+        Returns:
+            Number of threads (hardware concurrency unless overridden).
+        )pbdoc");
+
+    m.def("set_number_threads", &set_number_threads,
+        R"pbdoc(
+        Set the number of worker threads used by parallel operations.
+
+        Args:
+            number_threads: Number of threads, 0 to use hardware concurrency.
+        )pbdoc",
+        py::arg("number_threads"));
 }
 
 } // namespace PyMKF
\ No newline at end of file
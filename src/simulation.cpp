@@ -1,9 +1,11 @@
 #include "simulation.h"
+#include "lazy_database.h"
 
 namespace PyMKF {
 
 json simulate(json inputsJson, json magneticJson, json modelsData) {
     try {
+        materialize_references(inputsJson, magneticJson, modelsData);
         OpenMagnetics::Inputs inputs(inputsJson);
         OpenMagnetics::Magnetic magnetic(magneticJson);
         
@@ -39,6 +41,7 @@ json simulate(json inputsJson, json magneticJson, json modelsData) {
 
 ordered_json export_magnetic_as_subcircuit(json magneticJson) {
     try {
+        materialize_references(magneticJson);
         OpenMagnetics::Magnetic magnetic(magneticJson);
         ordered_json subcircuit = OpenMagnetics::CircuitSimulatorExporter().export_magnetic_as_subcircuit(magnetic);
         return subcircuit.dump(4);
@@ -52,6 +55,7 @@ ordered_json export_magnetic_as_subcircuit(json magneticJson) {
 
 json mas_autocomplete(json masJson, json configuration) {
     try {
+        materialize_all_records();
         OpenMagnetics::Mas mas(masJson);
         auto completedMas = OpenMagnetics::mas_autocomplete(mas, configuration);
         json result;
@@ -67,6 +71,7 @@ json mas_autocomplete(json masJson, json configuration) {
 
 json magnetic_autocomplete(json magneticJson, json configuration) {
     try {
+        materialize_all_records();
         OpenMagnetics::Magnetic magnetic(magneticJson);
         auto completedMagnetic = OpenMagnetics::magnetic_autocomplete(magnetic, configuration);
         json result;
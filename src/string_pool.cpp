@@ -0,0 +1,45 @@
+#include "string_pool.h"
+#include <mutex>
+
+namespace PyMKF {
+
+StringPool stringPool;
+
+std::string_view StringPool::intern(std::string_view text) {
+    _lookups.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        auto it = _strings.find(text);
+        if (it != _strings.end()) {
+            _savedBytes.fetch_add(text.size(), std::memory_order_relaxed);
+            return *it;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    auto [it, inserted] = _strings.emplace(text);
+    if (inserted) {
+        _bytes += it->capacity() + sizeof(std::string);
+    }
+    else {
+        _savedBytes.fetch_add(text.size(), std::memory_order_relaxed);
+    }
+    // Nodes of an unordered_set never move, so the view outlives rehashes
+    return *it;
+}
+
+size_t StringPool::size() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _strings.size();
+}
+
+json StringPool::get_statistics() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    json statistics;
+    statistics["strings"] = _strings.size();
+    statistics["bytes"] = _bytes + _strings.bucket_count() * sizeof(void*);
+    statistics["lookups"] = _lookups.load();
+    statistics["savedBytes"] = _savedBytes.load();
+    return statistics;
+}
+
+} // namespace PyMKF
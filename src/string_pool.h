@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common.h"
+#include <atomic>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_set>
+
+namespace PyMKF {
+
+// Process-wide pool of immutable strings. Interning the same text twice returns a view of the
+// same bytes, so every table keyed by database names (lazy index, reload baseline, fuzzy indexes)
+// shares one copy of each name and alias. Views stay valid for the life of the process: the pool
+// only grows with the distinct names ever loaded, which is bounded by the databases themselves.
+class StringPool {
+  public:
+    std::string_view intern(std::string_view text);
+    size_t size() const;
+    // Strings and bytes held, and the bytes callers would have held without interning
+    json get_statistics() const;
+
+  private:
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+
+    mutable std::shared_mutex _mutex;
+    std::unordered_set<std::string, Hash, std::equal_to<>> _strings;
+    size_t _bytes = 0;
+    std::atomic<uint64_t> _lookups{0};
+    std::atomic<uint64_t> _savedBytes{0};
+};
+
+extern StringPool stringPool;
+
+} // namespace PyMKF
@@ -1,9 +1,11 @@
 #include "winding.h"
+#include "lazy_database.h"
 
 namespace PyMKF {
 
 json wind(json coilJson, size_t repetitions, json proportionPerWindingJson, json patternJson, json marginPairsJson) {
     try {
+        materialize_references(coilJson, proportionPerWindingJson, patternJson, marginPairsJson);
         std::vector<std::vector<double>> marginPairs;
         for (auto elem : marginPairsJson) {
             std::vector<double> vectorElem;
@@ -142,6 +144,7 @@ json wind(json coilJson, size_t repetitions, json proportionPerWindingJson, json
 
 json wind_planar(json coilJson, json stackUpJson, double borderToWireDistance, json wireToWireDistanceJson, json insulationThicknessJson, double coreToLayerDistance) {
     try {
+        materialize_references(coilJson, stackUpJson, wireToWireDistanceJson, insulationThicknessJson);
         OpenMagnetics::settings->set_coil_wind_even_if_not_fit(true);
         auto coil = OpenMagnetics::Coil(coilJson, false);
         std::vector<size_t> stackUp = stackUpJson;
@@ -164,6 +167,7 @@ json wind_planar(json coilJson, json stackUpJson, double borderToWireDistance, j
 
 json wind_by_sections(json coilJson, size_t repetitions, json proportionPerWindingJson, json patternJson, double insulationThickness) {
     try {
+        materialize_references(coilJson, proportionPerWindingJson, patternJson);
 
         std::vector<double> proportionPerWinding = proportionPerWindingJson;
         std::vector<size_t> pattern = patternJson;
@@ -230,6 +234,7 @@ json wind_by_sections(json coilJson, size_t repetitions, json proportionPerWindi
 
 json wind_by_layers(json coilJson, json insulationLayersJson, double insulationThickness) {
     try {
+        materialize_references(coilJson, insulationLayersJson);
         std::map<std::pair<size_t, size_t>, std::vector<Layer>> insulationLayers;
 
         for (auto [key, layersJson] : insulationLayersJson.items()) {
@@ -293,6 +298,7 @@ json wind_by_layers(json coilJson, json insulationLayersJson, double insulationT
 
 json wind_by_turns(json coilJson) {
     try {
+        materialize_references(coilJson);
 
         std::vector<OpenMagnetics::Winding> winding;
         for (auto elem : coilJson["functionalDescription"]) {
@@ -342,6 +348,7 @@ json wind_by_turns(json coilJson) {
 
 json delimit_and_compact(json coilJson) {
     try {
+        materialize_references(coilJson);
 
         std::vector<OpenMagnetics::Winding> winding;
         for (auto elem : coilJson["functionalDescription"]) {
@@ -396,6 +403,7 @@ json delimit_and_compact(json coilJson) {
 
 json get_layers_by_winding_index(json coilJson, int windingIndex) {
     try {
+        materialize_references(coilJson);
         OpenMagnetics::Coil coil(coilJson, false);
 
         json result = json::array();
@@ -413,6 +421,7 @@ json get_layers_by_winding_index(json coilJson, int windingIndex) {
 
 json get_layers_by_section(json coilJson, json sectionName) {
     try {
+        materialize_references(coilJson, sectionName);
         json result = json::array();
         OpenMagnetics::Coil coil(coilJson, false);
         for (auto& layer : coil.get_layers_by_section(sectionName)) {
@@ -429,6 +438,7 @@ json get_layers_by_section(json coilJson, json sectionName) {
 
 json get_sections_description_conduction(json coilJson) {
     try {
+        materialize_references(coilJson);
         json result = json::array();
         OpenMagnetics::Coil coil(coilJson, false);
         for (auto& section : coil.get_sections_description_conduction()) {
@@ -445,6 +455,7 @@ json get_sections_description_conduction(json coilJson) {
 
 bool are_sections_and_layers_fitting(json coilJson) {
     try {
+        materialize_references(coilJson);
         json result = json::array();
         OpenMagnetics::Coil coil(coilJson, false);
         return coil.are_sections_and_layers_fitting();
@@ -457,6 +468,7 @@ bool are_sections_and_layers_fitting(json coilJson) {
 
 json add_margin_to_section_by_index(json coilJson, int sectionIndex, double top_or_left_margin, double bottom_or_right_margin) {
     try {
+        materialize_references(coilJson);
         OpenMagnetics::Coil coil(coilJson, false);
         coil.add_margin_to_section_by_index(sectionIndex, {top_or_left_margin, bottom_or_right_margin});
 
@@ -504,6 +516,7 @@ std::vector<int> calculate_number_turns(int numberTurnsPrimary, json designRequi
 
 json get_insulation_materials() {
     try {
+        materialize_all_records();
         auto insulationMaterials = OpenMagnetics::get_insulation_materials();
         json result = json::array();
         for (auto elem : insulationMaterials) {
@@ -522,6 +535,7 @@ json get_insulation_materials() {
 
 json get_insulation_material_names() {
     try {
+        materialize_all_records();
         auto insulationMaterialNames = OpenMagnetics::get_insulation_material_names();
         json result = json::array();
         for (auto elem : insulationMaterialNames) {
@@ -538,6 +552,7 @@ json get_insulation_material_names() {
 
 json find_insulation_material_by_name(json insulationMaterialName) {
     try {
+        materialize_references(insulationMaterialName);
         auto insulationMaterialData = OpenMagnetics::find_insulation_material_by_name(insulationMaterialName);
         json result;
         to_json(result, insulationMaterialData);
@@ -551,6 +566,7 @@ json find_insulation_material_by_name(json insulationMaterialName) {
 }
 
 json calculate_insulation(json inputsJson) {
+    materialize_all_records();
     auto standard = OpenMagnetics::InsulationCoordinator();
     OpenMagnetics::Inputs inputs(inputsJson, false);
 
@@ -576,6 +592,7 @@ json calculate_insulation(json inputsJson) {
 
 json get_insulation_layer_insulation_material(json coilJson, std::string layerName) {
     try {
+        materialize_references(coilJson);
         OpenMagnetics::Coil coil(coilJson, false);
         auto material = OpenMagnetics::Coil::resolve_insulation_layer_insulation_material(coil, layerName);
 
@@ -1,9 +1,12 @@
 #include "wire.h"
+#include "lazy_database.h"
+#include "wire_index.h"
 
 namespace PyMKF {
 
 json get_wires() {
     try {
+        materialize_all_records();
         auto wires = OpenMagnetics::get_wires();
         json result = json::array();
         for (auto elem : wires) {
@@ -22,6 +25,7 @@ json get_wires() {
 
 json get_wire_names() {
     try {
+        materialize_all_records();
         auto wireNames = OpenMagnetics::get_wire_names();
         json result = json::array();
         for (auto elem : wireNames) {
@@ -38,6 +42,7 @@ json get_wire_names() {
 
 json get_wire_materials() {
     try {
+        materialize_all_records();
         auto wireMaterials = OpenMagnetics::get_wire_materials();
         json result = json::array();
         for (auto elem : wireMaterials) {
@@ -56,6 +61,7 @@ json get_wire_materials() {
 
 json get_wire_material_names() {
     try {
+        materialize_all_records();
         auto wireMaterialNames = OpenMagnetics::get_wire_material_names();
         json result = json::array();
         for (auto elem : wireMaterialNames) {
@@ -72,6 +78,7 @@ json get_wire_material_names() {
 
 json find_wire_by_name(json wireName) {
     try {
+        materialize_references(wireName);
         auto wireData = OpenMagnetics::find_wire_by_name(wireName);
         json result;
         to_json(result, wireData);
@@ -86,6 +93,7 @@ json find_wire_by_name(json wireName) {
 
 json find_wire_material_by_name(json wireMaterialName) {
     try {
+        materialize_references(wireMaterialName);
         auto wireMaterialData = OpenMagnetics::find_wire_material_by_name(wireMaterialName);
         json result;
         to_json(result, wireMaterialData);
@@ -104,9 +112,15 @@ json find_wire_by_dimension(double dimension, json wireTypeJson, json wireStanda
         from_json(wireTypeJson, wireType);
         WireStandard wireStandard;
         from_json(wireStandardJson, wireStandard);
-        auto wireMaterialData = OpenMagnetics::find_wire_by_dimension(dimension, wireType, wireStandard, false);
+        auto index = get_wire_index();
         json result;
-        to_json(result, wireMaterialData);
+        if (auto wire = index->find_by_dimension(dimension, wireType, wireStandard)) {
+            to_json(result, *wire);
+        }
+        else {
+            auto wireMaterialData = OpenMagnetics::find_wire_by_dimension(dimension, wireType, wireStandard, false);
+            to_json(result, wireMaterialData);
+        }
         return result;
     }
     catch (const std::exception &exc) {
@@ -117,6 +131,7 @@ json find_wire_by_dimension(double dimension, json wireTypeJson, json wireStanda
 }
 
 json get_wire_data(json windingDataJson) {
+    materialize_references(windingDataJson);
     OpenMagnetics::Winding winding(windingDataJson);
     auto wire = OpenMagnetics::Coil::resolve_wire(winding);
     json result;
@@ -125,6 +140,7 @@ json get_wire_data(json windingDataJson) {
 }
 
 json get_wire_data_by_name(std::string name) {
+    materialize_record(name);
     auto wireData = OpenMagnetics::find_wire_by_name(name);
     json result;
     to_json(result, wireData);
@@ -132,26 +148,12 @@ json get_wire_data_by_name(std::string name) {
 }
 
 json get_wire_data_by_standard_name(std::string standardName) {
-    auto wires = OpenMagnetics::get_wires();
-    for (auto wire : wires) {
-        if (!wire.get_standard_name()) {
-            continue;
-        }
-        if (wire.get_standard_name().value() == standardName) {
-            auto coating = wire.resolve_coating();
-            if (!coating) {
-                continue;
-            }
-            if (!coating->get_grade()) {
-                continue;
-            }
-            // Hardcoded
-            if (coating->get_grade().value() == 1) {
-                json result;
-                to_json(result, wire);
-                return result;
-            }
-        }
+    auto index = get_wire_index();
+    // Hardcoded grade
+    if (auto wire = index->find_by_standard_name_and_grade(standardName, 1)) {
+        json result;
+        to_json(result, *wire);
+        return result;
     }
 
     json result;
@@ -160,29 +162,12 @@ json get_wire_data_by_standard_name(std::string standardName) {
 }
 
 json get_strand_by_standard_name(std::string standardName) {
-    auto wires = OpenMagnetics::get_wires();
-    for (auto wire : wires) {
-        if (!wire.get_standard_name()) {
-            continue;
-        }
-        auto coating = wire.resolve_coating();
-        if (!coating) {
-            continue;
-        }
-        // We are looking for enamelled wires for strands
-        if (coating->get_type() != InsulationWireCoatingType::ENAMELLED) {
-            continue;
-        }
-
-        if (!coating->get_grade()) {
-            throw std::runtime_error("Missing grade");
-        }
-
-        if (wire.get_standard_name().value() == standardName && coating->get_grade().value() == 1) {
-            json result;
-            to_json(result, wire);
-            return result;
-        }
+    auto index = get_wire_index();
+    // We are looking for grade 1 enamelled wires for strands
+    if (auto wire = index->find_strand_by_standard_name(standardName)) {
+        json result;
+        to_json(result, *wire);
+        return result;
     }
 
     json result;
@@ -191,14 +176,9 @@ json get_strand_by_standard_name(std::string standardName) {
 }
 
 double get_wire_conducting_diameter_by_standard_name(std::string standardName) {
-    auto wires = OpenMagnetics::get_wires();
-    for (auto wire : wires) {
-        if (!wire.get_standard_name()) {
-            continue;
-        }
-        if (wire.get_standard_name().value() == standardName) {
-            return OpenMagnetics::resolve_dimensional_values(wire.get_conducting_diameter().value());
-        }
+    auto index = get_wire_index();
+    if (auto wire = index->find_by_standard_name(standardName)) {
+        return OpenMagnetics::resolve_dimensional_values(wire->get_conducting_diameter().value());
     }
     return -1;
 }
@@ -246,12 +226,16 @@ double get_wire_outer_diameter_insulated_round(double conductingDiameter, int nu
 }
 
 std::vector<double> get_outer_dimensions(json wireJson) {
+    materialize_references(wireJson);
     OpenMagnetics::Wire wire(wireJson);
     return {wire.get_maximum_outer_width(), wire.get_maximum_outer_height()};
 }
 
 json get_equivalent_wire(json oldWireJson, json newWireTypeJson, double effectivefrequency) {
     try {
+        // The equivalent wire is picked from the wire database
+        materialize_references(oldWireJson);
+        materialize_section("wires");
         OpenMagnetics::Wire oldWire(oldWireJson);
         WireType newWireType;
         from_json(newWireTypeJson, newWireType);
@@ -270,6 +254,7 @@ json get_equivalent_wire(json oldWireJson, json newWireTypeJson, double effectiv
 
 json get_coating(json wireJson) {
     try {
+        materialize_references(wireJson);
         OpenMagnetics::Wire wire(wireJson);
         InsulationWireCoating insulationWireCoating;
         if (wire.resolve_coating()) {
@@ -289,6 +274,7 @@ json get_coating(json wireJson) {
 
 json get_coating_label(json wireJson) {
     try {
+        materialize_references(wireJson);
         OpenMagnetics::Wire wire(wireJson);
         auto coatingLabel = wire.encode_coating_label();
         return coatingLabel;
@@ -305,19 +291,10 @@ json get_coating_label(json wireJson) {
 }
 
 json get_wire_coating_by_label(std::string label) {
-    auto wires = OpenMagnetics::get_wires();
+    auto index = get_wire_index();
     InsulationWireCoating insulationWireCoating;
-    for (auto wire : wires) {
-        auto coatingLabel = wire.encode_coating_label();
-        if (coatingLabel == label) {
-            if (wire.resolve_coating()) {
-                insulationWireCoating = wire.resolve_coating().value();
-            }
-            else {
-                insulationWireCoating.set_type(InsulationWireCoatingType::BARE);
-            }
-            break;
-        }
+    if (auto coating = index->find_coating_by_label(label)) {
+        insulationWireCoating = *coating;
     }
     json result;
     to_json(result, insulationWireCoating);
@@ -326,22 +303,12 @@ json get_wire_coating_by_label(std::string label) {
 
 std::vector<std::string> get_coating_labels_by_type(json wireTypeJson) {
     WireType wireType(wireTypeJson);
-
-    auto wires = OpenMagnetics::get_wires(wireType);
-
-    std::vector<std::string> coatingLabels;
-    for (auto wire : wires) {
-        auto coatingLabel = wire.encode_coating_label();
-        if (std::find(coatingLabels.begin(), coatingLabels.end(), coatingLabel) == coatingLabels.end()) {
-            coatingLabels.push_back(coatingLabel);
-        }
-    }
-
-    return coatingLabels;
+    return get_wire_index()->get_coating_labels(wireType);
 }
 
 double get_coating_thickness(json wireJson) {
     try {
+        materialize_references(wireJson);
         OpenMagnetics::Wire wire(wireJson);
         return wire.get_coating_thickness();
     }
@@ -353,6 +320,7 @@ double get_coating_thickness(json wireJson) {
 
 double get_coating_relative_permittivity(json wireJson) {
     try {
+        materialize_references(wireJson);
         OpenMagnetics::Wire wire(wireJson);
         return wire.get_coating_relative_permittivity();
     }
@@ -364,6 +332,8 @@ double get_coating_relative_permittivity(json wireJson) {
 
 json get_coating_insulation_material(json wireJson) {
     try {
+        materialize_references(wireJson);
+        materialize_record(OpenMagnetics::defaults.defaultEnamelledInsulationMaterial);
         OpenMagnetics::Wire wire(wireJson);
         OpenMagnetics::InsulationMaterial material;
 
@@ -386,10 +356,12 @@ json get_coating_insulation_material(json wireJson) {
 }
 
 std::vector<std::string> get_available_wires() {
+    materialize_all_records();
     return OpenMagnetics::get_wire_names();
 }
 
 std::vector<std::string> get_unique_wire_diameters(json wireStandardJson) {
+    materialize_all_records();
     WireStandard wireStandard(wireStandardJson);
 
     auto wires = OpenMagnetics::get_wires(WireType::ROUND, wireStandard);
@@ -0,0 +1,184 @@
+#include "wire_index.h"
+#include "database.h"
+#include "lazy_database.h"
+#include <algorithm>
+#include <mutex>
+
+namespace PyMKF {
+
+namespace {
+
+std::optional<double> get_indexed_dimension(const OpenMagnetics::Wire& wire) {
+    switch (wire.get_type()) {
+        case WireType::ROUND:
+            if (wire.get_conducting_diameter()) {
+                return OpenMagnetics::resolve_dimensional_values(wire.get_conducting_diameter().value());
+            }
+            return std::nullopt;
+        case WireType::RECTANGULAR:
+        case WireType::FOIL:
+        case WireType::PLANAR:
+            if (wire.get_conducting_width()) {
+                return OpenMagnetics::resolve_dimensional_values(wire.get_conducting_width().value());
+            }
+            return std::nullopt;
+        default:
+            // Litz wires have no single conducting dimension, they keep going through OpenMagnetics
+            return std::nullopt;
+    }
+}
+
+std::mutex wireIndexMutex;
+std::shared_ptr<const WireIndex> currentWireIndex;
+uint64_t wireIndexDatabaseVersion = 0;
+size_t wireIndexDatabaseSize = 0;
+
+} // namespace
+
+WireIndex::WireIndex(std::vector<OpenMagnetics::Wire> wires) : _wires(std::move(wires)) {
+    for (size_t wireIndex = 0; wireIndex < _wires.size(); ++wireIndex) {
+        const auto& wire = _wires[wireIndex];
+
+        // A wire that cannot be labelled stops a linear scan, so the first failure is kept to be rethrown
+        std::optional<std::string> coatingLabel;
+        try {
+            coatingLabel = wire.encode_coating_label();
+        }
+        catch (...) {
+            if (!_firstCoatingLabelError) {
+                _firstCoatingLabelError = IndexedError{wireIndex, std::current_exception()};
+            }
+            _coatingLabelErrorsByType.try_emplace(wire.get_type(), std::current_exception());
+        }
+        if (coatingLabel) {
+            if (!_coatingsByLabel.contains(coatingLabel.value())) {
+                InsulationWireCoating insulationWireCoating;
+                if (wire.resolve_coating()) {
+                    insulationWireCoating = wire.resolve_coating().value();
+                }
+                else {
+                    insulationWireCoating.set_type(InsulationWireCoatingType::BARE);
+                }
+                _coatingsByLabel.emplace(coatingLabel.value(), CoatingEntry{wireIndex, insulationWireCoating});
+            }
+            auto& coatingLabels = _coatingLabelsByType[wire.get_type()];
+            if (std::find(coatingLabels.begin(), coatingLabels.end(), coatingLabel.value()) == coatingLabels.end()) {
+                coatingLabels.push_back(coatingLabel.value());
+            }
+        }
+
+        if (wire.get_standard()) {
+            auto dimension = get_indexed_dimension(wire);
+            if (dimension) {
+                _byDimension[{wire.get_type(), wire.get_standard().value()}].push_back({dimension.value(), wireIndex});
+            }
+        }
+
+        if (!wire.get_standard_name()) {
+            continue;
+        }
+        auto standardName = wire.get_standard_name().value();
+        _byStandardName.try_emplace(standardName, wireIndex);
+
+        auto coating = wire.resolve_coating();
+        if (!coating) {
+            continue;
+        }
+        if (!coating->get_grade()) {
+            // A linear scan for strands fails with "Missing grade" on the first ungraded enamelled wire it meets
+            if (coating->get_type() == InsulationWireCoatingType::ENAMELLED && !_firstUngradedEnamelledWire) {
+                _firstUngradedEnamelledWire = wireIndex;
+            }
+            continue;
+        }
+        auto grade = coating->get_grade().value();
+        _byStandardNameAndGrade.try_emplace({standardName, grade}, wireIndex);
+        if (coating->get_type() == InsulationWireCoatingType::ENAMELLED && grade == 1) {
+            _strandsByStandardName.try_emplace(standardName, wireIndex);
+        }
+    }
+
+    for (auto& [key, entries] : _byDimension) {
+        std::sort(entries.begin(), entries.end(), [](const DimensionEntry& a, const DimensionEntry& b) {
+            return a.dimension < b.dimension || (a.dimension == b.dimension && a.wireIndex < b.wireIndex);
+        });
+    }
+}
+
+const OpenMagnetics::Wire* WireIndex::find_by_standard_name(const std::string& standardName) const {
+    auto it = _byStandardName.find(standardName);
+    return it == _byStandardName.end() ? nullptr : &_wires[it->second];
+}
+
+const OpenMagnetics::Wire* WireIndex::find_by_standard_name_and_grade(const std::string& standardName, int64_t grade) const {
+    auto it = _byStandardNameAndGrade.find({standardName, grade});
+    return it == _byStandardNameAndGrade.end() ? nullptr : &_wires[it->second];
+}
+
+const OpenMagnetics::Wire* WireIndex::find_strand_by_standard_name(const std::string& standardName) const {
+    auto it = _strandsByStandardName.find(standardName);
+    if (_firstUngradedEnamelledWire && (it == _strandsByStandardName.end() || _firstUngradedEnamelledWire.value() < it->second)) {
+        throw std::runtime_error("Missing grade");
+    }
+    return it == _strandsByStandardName.end() ? nullptr : &_wires[it->second];
+}
+
+const InsulationWireCoating* WireIndex::find_coating_by_label(const std::string& label) const {
+    auto it = _coatingsByLabel.find(label);
+    if (_firstCoatingLabelError && (it == _coatingsByLabel.end() || _firstCoatingLabelError->wireIndex < it->second.wireIndex)) {
+        std::rethrow_exception(_firstCoatingLabelError->exception);
+    }
+    return it == _coatingsByLabel.end() ? nullptr : &it->second.coating;
+}
+
+std::vector<std::string> WireIndex::get_coating_labels(WireType wireType) const {
+    auto error = _coatingLabelErrorsByType.find(wireType);
+    if (error != _coatingLabelErrorsByType.end()) {
+        std::rethrow_exception(error->second);
+    }
+    auto it = _coatingLabelsByType.find(wireType);
+    return it == _coatingLabelsByType.end() ? std::vector<std::string>{} : it->second;
+}
+
+const OpenMagnetics::Wire* WireIndex::find_by_dimension(double dimension, WireType wireType, WireStandard wireStandard) const {
+    auto it = _byDimension.find({wireType, wireStandard});
+    if (it == _byDimension.end() || it->second.empty()) {
+        return nullptr;
+    }
+    const auto& entries = it->second;
+    auto byDimension = [](const DimensionEntry& entry, double value) { return entry.dimension < value; };
+
+    // Closest dimension at or above the target, and the first entry of the closest group below it
+    auto above = std::lower_bound(entries.begin(), entries.end(), dimension, byDimension);
+    const DimensionEntry* best = above != entries.end() ? &*above : nullptr;
+    if (above != entries.begin()) {
+        auto belowGroup = std::lower_bound(entries.begin(), above, std::prev(above)->dimension, byDimension);
+        if (best == nullptr) {
+            best = &*belowGroup;
+        }
+        else {
+            double distanceAbove = best->dimension - dimension;
+            double distanceBelow = dimension - belowGroup->dimension;
+            if (distanceBelow < distanceAbove || (distanceBelow == distanceAbove && belowGroup->wireIndex < best->wireIndex)) {
+                best = &*belowGroup;
+            }
+        }
+    }
+    return &_wires[best->wireIndex];
+}
+
+std::shared_ptr<const WireIndex> get_wire_index() {
+    std::lock_guard<std::mutex> lock(wireIndexMutex);
+    materialize_section("wires");
+    // The size catches OpenMagnetics loading its default wires on first use behind our back
+    if (currentWireIndex && wireIndexDatabaseVersion == get_database_version() && wireIndexDatabaseSize == OpenMagnetics::wireDatabase.size()) {
+        return currentWireIndex;
+    }
+    auto wires = OpenMagnetics::get_wires();
+    wireIndexDatabaseVersion = get_database_version();
+    wireIndexDatabaseSize = OpenMagnetics::wireDatabase.size();
+    currentWireIndex = std::make_shared<const WireIndex>(std::move(wires));
+    return currentWireIndex;
+}
+
+} // namespace PyMKF
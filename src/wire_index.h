@@ -0,0 +1,55 @@
+#pragma once
+
+#include "common.h"
+#include <exception>
+#include <memory>
+
+namespace PyMKF {
+
+// Lookup tables over the wire database. Every lookup returns the same wire a linear scan of
+// OpenMagnetics::get_wires() would return first, or nullptr when there is none, and throws
+// whatever that scan would have thrown before reaching it.
+class WireIndex {
+  public:
+    explicit WireIndex(std::vector<OpenMagnetics::Wire> wires);
+
+    const OpenMagnetics::Wire* find_by_standard_name(const std::string& standardName) const;
+    const OpenMagnetics::Wire* find_by_standard_name_and_grade(const std::string& standardName, int64_t grade) const;
+    const OpenMagnetics::Wire* find_strand_by_standard_name(const std::string& standardName) const;
+    const InsulationWireCoating* find_coating_by_label(const std::string& label) const;
+    std::vector<std::string> get_coating_labels(WireType wireType) const;
+    // Wire whose conducting diameter (round) or conducting width (rectangular, foil, planar) is closest to dimension
+    const OpenMagnetics::Wire* find_by_dimension(double dimension, WireType wireType, WireStandard wireStandard) const;
+
+  private:
+    struct DimensionEntry {
+        double dimension;
+        size_t wireIndex;
+    };
+    struct CoatingEntry {
+        size_t wireIndex;
+        InsulationWireCoating coating;
+    };
+    struct IndexedError {
+        size_t wireIndex;
+        std::exception_ptr exception;
+    };
+
+    std::vector<OpenMagnetics::Wire> _wires;
+    std::map<std::string, size_t> _byStandardName;
+    std::map<std::pair<std::string, int64_t>, size_t> _byStandardNameAndGrade;
+    std::map<std::string, size_t> _strandsByStandardName;
+    std::map<std::string, CoatingEntry> _coatingsByLabel;
+    std::map<WireType, std::vector<std::string>> _coatingLabelsByType;
+    std::map<WireType, std::exception_ptr> _coatingLabelErrorsByType;
+    std::optional<IndexedError> _firstCoatingLabelError;
+    std::optional<size_t> _firstUngradedEnamelledWire;
+    // Sorted by dimension, then by position in the database so ties resolve like a linear scan
+    std::map<std::pair<WireType, WireStandard>, std::vector<DimensionEntry>> _byDimension;
+};
+
+// Index for the current databases, rebuilt the first time it is requested after a load, reload or clear.
+// The returned pointer stays valid for the caller even if the databases are reloaded meanwhile.
+std::shared_ptr<const WireIndex> get_wire_index();
+
+} // namespace PyMKF
@@ -4,6 +4,7 @@ Tests for PyMKF Core data retrieval and calculations.
 These tests mirror TestCore.cpp and TestCoreAdviser.cpp from MKF,
 verifying core shape, material, and gapping calculations.
 """
+import json
 import pytest
 import PyMKF
 
@@ -110,6 +111,20 @@ class TestCoreMaterialProperties:
         # Typical ferrite permeability range
         assert 10 < permeability < 100000
 
+    def test_get_material_permeability_batch(self):
+        """Batch permeability should broadcast its inputs and match the scalar call."""
+        import numpy as np
+        temperatures = np.array([25.0, 100.0])
+        biases = np.array([[0.0], [100.0], [200.0]])
+        permeabilities = PyMKF.get_material_permeability_batch("3C95", temperatures, biases, 100000.0)
+
+        assert isinstance(permeabilities, np.ndarray)
+        assert permeabilities.shape == (3, 2)
+        for row, bias in enumerate(biases[:, 0]):
+            for column, temperature in enumerate(temperatures):
+                expected = PyMKF.get_material_permeability("3C95", temperature, bias, 100000.0)
+                assert permeabilities[row, column] == pytest.approx(expected)
+
     def test_get_material_resistivity(self):
         """
         Material resistivity calculation.
@@ -135,6 +150,45 @@ class TestCoreMaterialProperties:
             assert isinstance(coeffs, dict)
             assert len(coeffs) > 0
 
+    def test_calculate_steinmetz_coefficients_batch(self):
+        """A dataset that cannot be fitted should only fail its own entry."""
+        results = PyMKF.calculate_steinmetz_coefficients_batch([
+            {"name": "missing data", "ranges": [[10000, 100000]]},
+            {"name": "bad range", "data": [], "ranges": "not a range"},
+        ])
+        assert isinstance(results, list)
+        assert len(results) == 2
+        assert all(isinstance(result, str) and result.startswith("Exception") for result in results)
+        assert PyMKF.calculate_steinmetz_coefficients_batch([]) == []
+
+    def test_calculate_steinmetz_coefficients_batch_matches_single_fit(self):
+        """A dataset fitted in a batch should give the same result as fitting it on its own."""
+        data = []
+        for frequency in [25000, 50000, 100000, 200000, 400000]:
+            for peak in [0.025, 0.05, 0.1, 0.2]:
+                data.append({
+                    "origin": "manufacturer",
+                    "temperature": 25,
+                    "value": 1.5 * frequency ** 1.4 * peak ** 2.5,
+                    "magneticFluxDensity": {
+                        "frequency": frequency,
+                        "magneticFluxDensity": {"processed": {"label": "Sinusoidal", "offset": 0, "peak": peak}}
+                    }
+                })
+        ranges = [[20000, 150000], [150000, 500000]]
+        expected = PyMKF.calculate_steinmetz_coefficients_with_error(data, ranges)
+        assert isinstance(expected, dict)
+
+        results = PyMKF.calculate_steinmetz_coefficients_batch([
+            {"name": "synthetic", "data": data, "ranges": ranges},
+            {"name": "missing data", "ranges": ranges},
+            {"data": data, "ranges": ranges},
+        ])
+        assert results[0].pop("name") == "synthetic"
+        assert results[0] == expected
+        assert results[1].startswith("Exception")
+        assert results[2] == expected
+
     @pytest.mark.xfail(reason="get_core_material_available_losses_methods not implemented in PyMKF")
     def test_get_available_losses_methods(self):
         """Should retrieve available loss calculation methods."""
@@ -145,6 +199,52 @@ class TestCoreMaterialProperties:
             assert isinstance(methods, list)
 
 
+class TestMaterialSurfaceCache:
+    """Test suite for the interpolated material property cache."""
+
+    def test_interpolated_values_match_exact_model(self):
+        """Queries inside the grid should be interpolated close to the exact model."""
+        exact = PyMKF.get_material_permeability("3C95", 60.0, 50.0, 150000.0)
+        exact_resistivity = PyMKF.get_material_resistivity("3C95", 60.0)
+        assert PyMKF.set_material_surface_cache(True, {"temperature": {"minimum": 0, "maximum": 120, "points": 25}}) == "0"
+        try:
+            interpolated = PyMKF.get_material_permeability("3C95", 60.0, 50.0, 150000.0)
+            interpolated_resistivity = PyMKF.get_material_resistivity("3C95", 60.0)
+            # Outside the temperature grid, answered by the exact model
+            PyMKF.get_material_permeability("3C95", 150.0, 50.0, 150000.0)
+
+            statistics = PyMKF.get_material_surface_cache_statistics()
+            assert statistics["enabled"]
+            assert statistics["hits"] >= 2
+            assert statistics["misses"] >= 1
+            permeability = statistics["materials"]["3C95"]["permeability"]
+            assert permeability["available"]
+            assert interpolated == pytest.approx(exact, rel=max(permeability["maximumRelativeError"], 1e-9) * 2)
+            assert interpolated_resistivity == pytest.approx(exact_resistivity, rel=0.05)
+        finally:
+            PyMKF.set_material_surface_cache(False)
+            PyMKF.clear_material_surface_cache()
+
+    def test_steinmetz_coefficients_are_kept_per_range(self):
+        """A frequency sweep should keep one entry per Steinmetz range, with the exact model's coefficients."""
+        frequencies = [20000.0 + 997.0 * index for index in range(200)]
+        exact = [PyMKF.get_core_material_steinmetz_coefficients("3C95", frequency) for frequency in frequencies]
+        assert PyMKF.set_material_surface_cache(True, {}) == "0"
+        try:
+            cached = [PyMKF.get_core_material_steinmetz_coefficients("3C95", frequency) for frequency in frequencies]
+            assert cached == exact
+            statistics = PyMKF.get_material_surface_cache_statistics()
+            assert statistics["materials"]["3C95"]["steinmetzRanges"] <= len({json.dumps(coefficients, sort_keys=True) for coefficients in exact})
+        finally:
+            PyMKF.set_material_surface_cache(False)
+            PyMKF.clear_material_surface_cache()
+
+    def test_invalid_grid(self):
+        """A grid axis with a single point should be rejected."""
+        result = PyMKF.set_material_surface_cache(True, {"frequency": {"points": 1}})
+        assert result.startswith("Exception")
+
+
 class TestCoreCalculations:
     """Test suite for core calculations - mirrors tests in TestCore.cpp"""
 
@@ -159,6 +259,49 @@ class TestCoreCalculations:
         assert isinstance(result, dict)
         assert "processedDescription" in result or "functionalDescription" in result
 
+    def test_calculate_core_data_batch(self, sample_core_data):
+        """Batch processing should keep input order and report failed cores individually."""
+        broken = {"functionalDescription": {"type": "two-piece set", "material": "3C95", "shape": "Not a shape", "gapping": [], "numberStacks": 1}}
+        results = PyMKF.calculate_core_data_batch([sample_core_data, broken, sample_core_data])
+
+        assert len(results) == 3
+        assert results[0] == PyMKF.calculate_core_data(sample_core_data, False)
+        assert isinstance(results[1], str) and results[1].startswith("Exception")
+        assert results[2] == results[0]
+
+        processed = PyMKF.calculate_core_data_batch([sample_core_data], output="processedDescription")
+        assert processed[0] == PyMKF.calculate_core_processed_description(sample_core_data)
+
+    def test_parallel_batches_match_serial_processing(self, sample_core_data, sample_toroidal_core):
+        """Cores processed on the worker threads should match the same cores processed one by one."""
+        PyMKF.clear_core_processing_cache()
+        cores = [sample_core_data, sample_toroidal_core] * 8
+        serial = [PyMKF.calculate_core_data(core, False) for core in cores]
+
+        PyMKF.clear_core_processing_cache()
+        assert PyMKF.calculate_core_data_batch(cores) == serial
+        PyMKF.clear_core_processing_cache()
+        assert PyMKF.load_core_data(cores) == serial
+
+    def test_core_processing_cache(self, sample_core_data):
+        """Processing the same core twice should hit the cache and give the same result."""
+        PyMKF.clear_core_processing_cache()
+        first = PyMKF.calculate_core_data(sample_core_data, False)
+        renamed = dict(sample_core_data, name="Renamed core")
+        second = PyMKF.calculate_core_data(renamed, False)
+
+        statistics = PyMKF.get_core_processing_cache_statistics()
+        assert statistics["misses"] >= 1
+        assert statistics["hits"] >= 1
+        assert second["processedDescription"] == first["processedDescription"]
+        assert second["geometricalDescription"] == first["geometricalDescription"]
+
+        assert PyMKF.set_core_processing_cache_size(0) == "0"
+        try:
+            assert PyMKF.get_core_processing_cache_statistics()["entries"] == 0
+        finally:
+            PyMKF.set_core_processing_cache_size(1024)
+
     def test_calculate_core_geometrical_description(self, sample_core_data):
         """Calculate core geometrical description."""
         result = PyMKF.calculate_core_geometrical_description(sample_core_data)
@@ -181,6 +324,110 @@ class TestCoreCalculations:
             assert isinstance(gapping, list)
 
 
+class TestInductanceSweep:
+    """Test suite for the turns by gap length inductance sweep."""
+
+    def test_sweep_matches_single_evaluation(self, sample_core_data, simple_winding, triangular_operating_point):
+        """Each cell should match the single-point binding, with inductance growing as turns squared."""
+        import numpy as np
+        coil = {"bobbin": "Dummy", "functionalDescription": simple_winding}
+        sweep = PyMKF.calculate_inductance_sweep(sample_core_data, coil, triangular_operating_point, [10, 20, 31], [0.0001, 0.0005, 0.001])
+
+        inductance = sweep["magnetizingInductance"]
+        assert isinstance(inductance, np.ndarray)
+        assert inductance.shape == (3, 3)
+        assert sweep["magneticFluxDensityPeak"].shape == (3, 3)
+        assert np.all(np.diff(inductance, axis=1) < 0)
+        assert inductance[1] / inductance[0] == pytest.approx(np.full(3, 4.0), rel=1e-6)
+
+        expected = PyMKF.calculate_inductance_from_number_turns_and_gapping(sample_core_data, coil, triangular_operating_point, {})
+        assert inductance[2, 0] == pytest.approx(expected, rel=1e-6)
+
+    def test_sweep_over_reluctance_models(self, sample_core_data, simple_winding, triangular_operating_point):
+        """Giving reluctance models should add a leading axis."""
+        coil = {"bobbin": "Dummy", "functionalDescription": simple_winding}
+        sweep = PyMKF.calculate_inductance_sweep(sample_core_data, coil, triangular_operating_point, [10, 20], [0.0001, 0.0005, 0.001], ["ZHANG", "MUEHLETHALER"])
+        assert sweep["magnetizingInductance"].shape == (2, 2, 3)
+
+
+class TestGapSolver:
+    """Test suite for the gap length and number of turns solvers."""
+
+    def test_solve_gapping(self, sample_core_data, simple_winding, inductor_inputs):
+        """The solved gap should give the required inductance within tolerance."""
+        coil = {"bobbin": "Dummy", "functionalDescription": simple_winding}
+        result = PyMKF.solve_gapping_from_number_turns_and_inductance(sample_core_data, coil, inductor_inputs, tolerance=1e-4)
+
+        assert result["converged"]
+        assert abs(result["residual"]) <= 1e-4
+        assert result["iterations"] > 0
+        assert "core" not in result
+        core = dict(sample_core_data)
+        core["functionalDescription"] = dict(core["functionalDescription"], gapping=result["gapping"])
+        inductance = PyMKF.calculate_inductance_from_number_turns_and_gapping(core, coil, inductor_inputs["operatingPoints"][0], {})
+        assert inductance == pytest.approx(100e-6, rel=1e-3)
+
+    def test_solve_number_turns(self, sample_core_data, simple_winding, inductor_inputs):
+        """The solved number of turns should be the closest whole number to the exact solution."""
+        coil = {"bobbin": "Dummy", "functionalDescription": simple_winding}
+        result = PyMKF.solve_number_turns_from_gapping_and_inductance(sample_core_data, coil, inductor_inputs)
+
+        assert result["settled"]
+        assert result["converged"] == (abs(result["residual"]) <= 1e-6)
+        assert result["numberTurns"] >= 1
+        assert abs(result["numberTurns"] - result["exactNumberTurns"]) <= 1
+
+        loose = PyMKF.solve_number_turns_from_gapping_and_inductance(sample_core_data, coil, inductor_inputs, tolerance=0.5)
+        assert loose["converged"]
+        assert abs(loose["residual"]) <= 0.5
+
+    def test_ungapped_core_is_reported(self, sample_core_data, simple_winding, inductor_inputs):
+        """A core without a gap to solve should return an exception."""
+        core = dict(sample_core_data)
+        core["functionalDescription"] = dict(core["functionalDescription"], gapping=[])
+        coil = {"bobbin": "Dummy", "functionalDescription": simple_winding}
+        result = PyMKF.solve_gapping_from_number_turns_and_inductance(core, coil, inductor_inputs)
+        assert result["data"].startswith("Exception")
+
+
+class TestGapReluctanceBatch:
+    """Test suite for batch gap reluctance evaluation."""
+
+    def test_batch_matches_single_gap(self, sample_core_data):
+        """Each cell should match calculate_gap_reluctance for that gap and model."""
+        import numpy as np
+        gaps = PyMKF.calculate_core_gapping(sample_core_data)
+        result = PyMKF.calculate_gap_reluctance_batch(gaps)
+
+        assert len(result["models"]) > 1
+        assert result["reluctance"].shape == (len(result["models"]), len(gaps))
+        assert result["fringingFactor"].shape == result["reluctance"].shape
+        model = result["models"][0]
+        single = PyMKF.calculate_gap_reluctance(gaps[0], model)
+        assert result["reluctance"][0, 0] == pytest.approx(single["reluctance"])
+        assert result["fringingFactor"][0, 0] == pytest.approx(single["fringingFactor"])
+
+        only_one = PyMKF.calculate_gap_reluctance_batch(gaps + [{"type": "broken"}], [model])
+        assert only_one["reluctance"].shape == (1, len(gaps) + 1)
+        assert np.isnan(only_one["reluctance"][0, -1])
+
+
+class TestTemperatureSweep:
+    """Test suite for the temperature sweep of core parameters."""
+
+    def test_sweep_matches_single_temperature(self, sample_core_data):
+        """Each row of the sweep should match the single-temperature call."""
+        import numpy as np
+        temperatures = np.array([25.0, 100.0])
+        sweep = PyMKF.get_core_temperature_dependant_parameters_sweep(sample_core_data, temperatures)
+
+        for index, temperature in enumerate(temperatures):
+            expected = PyMKF.get_core_temperature_dependant_parameters(sample_core_data, temperature)
+            for key, value in expected.items():
+                assert sweep[key].shape == temperatures.shape
+                assert sweep[key][index] == pytest.approx(value)
+
+
 class TestCoreProcessedDescription:
     """Test suite for processed core descriptions."""
 
@@ -218,3 +465,114 @@ class TestCoreProcessedDescription:
             if "windingWindows" in processed:
                 assert isinstance(processed["windingWindows"], list)
                 assert len(processed["windingWindows"]) > 0
+
+
+class TestCoreCatalogTable:
+    """Test suite for the columnar core catalog."""
+
+    def test_catalog_matches_available_cores(self):
+        """Columns should have one row per core, in get_available_cores order."""
+        cores = PyMKF.get_available_cores()
+        table = PyMKF.get_core_catalog_table()
+
+        assert len(table["reference"]) == len(cores)
+        for column in ["effectiveArea", "effectiveLength", "effectiveVolume", "windingWindowArea",
+                       "columnArea", "areaProduct", "estimatedMass", "numberStacks", "materialId", "shapeId"]:
+            assert len(table[column]) == len(cores)
+
+        core = cores[0]
+        area_product = core["processedDescription"]["columns"][0]["area"] * core["processedDescription"]["windingWindows"][0]["area"]
+        assert table["areaProduct"][0] == pytest.approx(area_product)
+        assert table["shapeNames"][table["shapeId"][0]] == core["functionalDescription"]["shape"]["name"]
+
+    def test_catalog_columns_are_read_only(self):
+        """Columns are shared between calls, so they must not be writable."""
+        table = PyMKF.get_core_catalog_table()
+        assert not table["effectiveArea"].flags.writeable
+        with pytest.raises(ValueError):
+            table["effectiveArea"][0] = 0
+
+
+class TestQueryCores:
+    """Test suite for range queries over the core catalog."""
+
+    def test_area_product_range_matches_scan(self):
+        """Range query should return the same cores as scanning the catalog, as test.py does."""
+        table = PyMKF.get_core_catalog_table()
+        minimum, maximum = 70e-8 * 0.95, 70e-8 * 1.05
+        expected = [reference for reference, area_product in zip(table["reference"], table["areaProduct"])
+                    if minimum <= area_product <= maximum]
+
+        result = PyMKF.query_cores({"areaProduct": [minimum, maximum]})
+        assert result == expected
+
+    def test_filters_and_fields(self):
+        """Filters should narrow the result and selected fields should be returned."""
+        result = PyMKF.query_cores({"effectiveArea": [None, 1]}, {"family": "ETD"}, ["family", "effectiveArea", "material"])
+        assert len(result) > 0
+        for core in result:
+            assert core["family"] == "etd"
+            assert "reference" in core
+            assert "material" in core
+
+    def test_unknown_range_returns_error(self):
+        """Unknown columns should be reported instead of ignored."""
+        result = PyMKF.query_cores({"volume": [0, 1]})
+        assert "Exception" in result["data"]
+
+
+class TestCoreEnergyMap:
+    """Test suite for the catalog-wide saturation and energy map."""
+
+    def test_query_matches_table(self):
+        """Energy queries should return the cores of the table above the requirement, smallest first."""
+        import numpy as np
+        table = PyMKF.get_core_energy_map_table([25.0, 100.0])
+        assert table["maximumMagneticEnergy"].shape == (2, len(table["reference"]))
+        assert table["saturationAmpereTurns"].shape == (2, len(table["reference"]))
+
+        energies = table["maximumMagneticEnergy"][1]
+        required = float(np.nanmedian(energies))
+        result = PyMKF.query_cores_by_energy(required, 80.0)
+        assert len(result) == int(np.sum(energies >= required))
+        assert all(core["temperature"] == 100.0 for core in result)
+        found = [core["maximumMagneticEnergy"] for core in result]
+        assert found == sorted(found)
+        assert found[0] >= required
+
+        assert len(PyMKF.query_cores_by_energy(required, 80.0, 3)) == 3
+
+    def test_temperature_above_map_returns_error(self):
+        """Temperatures hotter than every precomputed one cannot be answered safely."""
+        PyMKF.get_core_energy_map_table([25.0, 100.0])
+        result = PyMKF.query_cores_by_energy(1e-3, 150.0)
+        assert "Exception" in result["data"]
+
+
+class TestCatalogFacets:
+    """Test suite for the faceted catalog summary."""
+
+    def test_facets_match_name_lists(self):
+        """Facets should agree with the manufacturer and shape family lists."""
+        facets = PyMKF.get_catalog_facets()
+        manufacturers = PyMKF.get_available_core_manufacturers()
+        assert [facet["name"] for facet in facets["manufacturers"]] == manufacturers
+        assert set(facets["materialsByManufacturer"].keys()) == set(manufacturers)
+        assert set(PyMKF.get_core_shape_families()) <= {facet["name"] for facet in facets["families"]}
+
+        assert facets["counts"]["cores"] == len(PyMKF.get_core_catalog_table()["reference"])
+        assert sum(facet["shapes"] for facet in facets["families"]) == facets["counts"]["shapes"]
+        for facet in facets["manufacturers"]:
+            assert facet["materials"] == len(facets["materialsByManufacturer"][facet["name"]])
+
+    def test_facets_are_stable(self):
+        """Repeated calls should return the same summary."""
+        assert PyMKF.get_catalog_facets() == PyMKF.get_catalog_facets()
+
+    def test_name_lists_do_not_load_cores(self):
+        """Manufacturer and shape family lists should only need the material and shape databases."""
+        PyMKF.clear_databases()
+        cores_before = PyMKF.get_memory_usage()["cores"]["records"]
+        assert len(PyMKF.get_available_core_manufacturers()) > 0
+        assert len(PyMKF.get_core_shape_families()) > 0
+        assert PyMKF.get_memory_usage()["cores"]["records"] == cores_before
@@ -0,0 +1,388 @@
+"""
+Tests for PyMKF database loading, snapshots and caches.
+"""
+import copy
+import json
+import pytest
+import PyMKF
+
+
+class TestDatabaseSnapshot:
+    """Test suite for binary database snapshots."""
+
+    def test_snapshot_round_trip(self, tmp_path):
+        """A saved snapshot should restore the same records."""
+        names = PyMKF.get_core_material_names()
+        wire_names = PyMKF.get_wire_names()
+        snapshot = str(tmp_path / "databases.bin")
+
+        assert PyMKF.save_database_snapshot(snapshot) == "0"
+        PyMKF.clear_databases()
+        assert PyMKF.load_database_snapshot(snapshot) == "0"
+
+        assert not PyMKF.is_core_material_database_empty()
+        assert sorted(PyMKF.get_core_material_names()) == sorted(names)
+        assert sorted(PyMKF.get_wire_names()) == sorted(wire_names)
+
+    def test_lazy_snapshot_decodes_on_first_use(self, tmp_path):
+        """A lazily loaded snapshot should only decode the records that are looked up."""
+        names = PyMKF.get_core_material_names()
+        snapshot = str(tmp_path / "databases.bin")
+        assert PyMKF.save_database_snapshot(snapshot) == "0"
+        PyMKF.clear_databases()
+
+        assert PyMKF.load_database_snapshot(snapshot) == "0"
+        statistics = PyMKF.get_lazy_loading_statistics()
+        assert statistics["enabled"]
+        assert statistics["coreMaterials"]["indexed"] >= len(names)
+        assert statistics["materialized"] == 0
+        assert PyMKF.find_core_material_by_name("3C95")["name"] == "3C95"
+        assert PyMKF.get_lazy_loading_statistics()["materialized"] < statistics["indexed"]
+        assert sorted(PyMKF.get_core_material_names()) == sorted(names)
+
+        assert PyMKF.load_database_snapshot(snapshot, False) == "0"
+        assert not PyMKF.get_lazy_loading_statistics()["enabled"]
+        assert sorted(PyMKF.get_core_material_names()) == sorted(names)
+        PyMKF.clear_databases()
+
+    def test_snapshot_rejects_other_files(self, tmp_path):
+        """Loading something that is not a snapshot should fail without clearing the databases."""
+        bogus = tmp_path / "bogus.bin"
+        bogus.write_bytes(b"not a snapshot" * 16)
+        result = PyMKF.load_database_snapshot(str(bogus))
+        assert result != "0"
+        assert not PyMKF.is_core_material_database_empty()
+
+
+class TestReadDatabases:
+    """Test suite for ndjson ingestion through read_databases."""
+
+    def test_read_databases_reports_statistics(self, tmp_path):
+        """Each ndjson file should report its records and parse time."""
+        materials = PyMKF.get_core_materials()
+        with open(tmp_path / "core_materials.ndjson", "w") as f:
+            for material in materials:
+                f.write(json.dumps(material) + "\n")
+
+        assert PyMKF.read_databases(str(tmp_path), False) == "0"
+        statistics = PyMKF.get_database_ingestion_statistics()
+        assert statistics["core_materials.ndjson"]["found"]
+        assert statistics["core_materials.ndjson"]["records"] == len({m["name"] for m in materials})
+        assert statistics["core_materials.ndjson"]["parseSeconds"] >= 0
+        assert not statistics["wires.ndjson"]["found"]
+
+
+class TestReloadDatabases:
+    """Test suite for incremental database reloads."""
+
+    def test_reload_applies_only_changes(self, tmp_path):
+        """Editing a material file should add, update and remove only the affected records."""
+        materials = PyMKF.get_core_materials()[:3]
+        path = tmp_path / "core_materials.ndjson"
+        path.write_text("".join(json.dumps(material) + "\n" for material in materials))
+        assert PyMKF.read_databases(str(tmp_path), False) == "0"
+
+        report = PyMKF.reload_databases(str(tmp_path))
+        assert not report["core_materials.ndjson"]["changed"]
+
+        removed = materials.pop()
+        materials[0]["name"] = "Reloaded material"
+        path.write_text("".join(json.dumps(material) + "\n" for material in materials))
+        report = PyMKF.reload_databases(str(tmp_path))["core_materials.ndjson"]
+        assert report["changed"]
+        assert report["added"] == 1
+        assert report["removed"] == 2
+        assert "Reloaded material" in PyMKF.get_core_material_names()
+        assert removed["name"] not in PyMKF.get_core_material_names()
+        PyMKF.clear_databases()
+
+    def test_invalid_record_leaves_databases_untouched(self, tmp_path):
+        """A record that fails to build should abort the reload before anything is applied."""
+        materials = PyMKF.get_core_materials()[:2]
+        path = tmp_path / "core_materials.ndjson"
+        path.write_text("".join(json.dumps(material) + "\n" for material in materials))
+        assert PyMKF.read_databases(str(tmp_path), False) == "0"
+
+        materials[0]["name"] = "Renamed material"
+        lines = [json.dumps(material) for material in materials] + [json.dumps({"name": "Broken material"})]
+        path.write_text("".join(line + "\n" for line in lines))
+        report = PyMKF.reload_databases(str(tmp_path))
+        assert "Exception" in report["data"]
+        names = PyMKF.get_core_material_names()
+        assert "Renamed material" not in names
+        assert "Broken material" not in names
+        assert materials[1]["name"] in names
+        PyMKF.clear_databases()
+
+
+class TestLazyLoading:
+    """Test suite for lazy, on-demand database materialization."""
+
+    def test_lookup_materializes_only_touched_records(self):
+        """A lazy load should only build the records that are looked up."""
+        PyMKF.load_databases({}, lazy=True)
+        statistics = PyMKF.get_lazy_loading_statistics()
+        assert statistics["enabled"]
+        assert statistics["indexed"] > 0
+        assert statistics["materialized"] == 0
+
+        material = PyMKF.find_core_material_by_name("3C95")
+        assert material["name"] == "3C95"
+        statistics = PyMKF.get_lazy_loading_statistics()
+        assert statistics["coreMaterials"]["materialized"] >= 1
+        assert statistics["materialized"] < statistics["indexed"]
+
+    def test_enumeration_sees_whole_database(self):
+        """Listing a database in lazy mode should return every record."""
+        PyMKF.clear_databases()
+        eager_names = PyMKF.get_core_material_names()
+
+        PyMKF.load_databases({}, lazy=True)
+        PyMKF.find_core_material_by_name("N87")
+        assert sorted(PyMKF.get_core_material_names()) == sorted(eager_names)
+
+        PyMKF.clear_databases()
+        assert not PyMKF.get_lazy_loading_statistics()["enabled"]
+
+    def test_load_magnetic_materializes_references(self, sample_core_data, simple_winding):
+        """Loading a magnetic in lazy mode should build the shape and material it names."""
+        PyMKF.load_databases({}, lazy=True)
+        PyMKF.clear_mas()
+        magnetic = {"core": sample_core_data, "coil": {"bobbin": "Dummy", "functionalDescription": simple_winding}}
+        assert PyMKF.load_magnetic("lazy inductor", magnetic, False) == "1"
+        statistics = PyMKF.get_lazy_loading_statistics()
+        assert statistics["coreShapes"]["materialized"] >= 1
+        assert statistics["coreMaterials"]["materialized"] >= 1
+        PyMKF.clear_mas()
+        PyMKF.clear_databases()
+
+    def test_wire_lookup_materializes_only_wires(self):
+        """Wire lookups should build the wire database, not every core material and shape."""
+        PyMKF.load_databases({}, lazy=True)
+        found = PyMKF.find_wire_by_dimension(0.001, "round", "IEC 60317")
+        assert found["type"] == "round"
+        statistics = PyMKF.get_lazy_loading_statistics()
+        assert statistics["wires"]["materialized"] == statistics["wires"]["indexed"]
+        assert statistics["coreMaterials"]["materialized"] == 0
+        assert statistics["coreShapes"]["materialized"] == 0
+        PyMKF.clear_databases()
+
+    def test_reload_after_editing_lazily_read_file(self, tmp_path):
+        """Rewriting a lazily read file in place should not break lookups or the reload."""
+        materials = PyMKF.get_core_materials()[:3]
+        path = tmp_path / "core_materials.ndjson"
+        path.write_text("".join(json.dumps(material) + "\n" for material in materials))
+        assert PyMKF.read_databases(str(tmp_path), False, True) == "0"
+
+        renamed = copy.deepcopy(materials[0])
+        renamed["name"] = "Reloaded material"
+        path.write_text(json.dumps(renamed) + "\n")
+        assert PyMKF.find_core_material_by_name(materials[1]["name"])["name"] == materials[1]["name"]
+
+        report = PyMKF.reload_databases(str(tmp_path))
+        assert report["core_materials.ndjson"]["changed"]
+        assert "Reloaded material" in PyMKF.get_core_material_names()
+        PyMKF.clear_databases()
+
+    def test_core_batch_materializes_references(self, sample_core_data, sample_toroidal_core):
+        """Processing cores in lazy mode should only build the shapes and materials they name."""
+        PyMKF.load_databases({}, lazy=True)
+        results = PyMKF.calculate_core_data_batch([sample_core_data, sample_toroidal_core])
+        statistics = PyMKF.get_lazy_loading_statistics()
+        assert statistics["materialized"] < statistics["indexed"]
+        assert results[0] == PyMKF.calculate_core_data(sample_core_data, False)
+        assert results[1] == PyMKF.calculate_core_data(sample_toroidal_core, False)
+        PyMKF.clear_databases()
+
+
+class TestMasStore:
+    """Test suite for the store of loaded MAS objects."""
+
+    def _magnetic(self, sample_core_data, simple_winding):
+        return {
+            "core": sample_core_data,
+            "coil": {"bobbin": "Dummy", "functionalDescription": simple_winding}
+        }
+
+    def test_missing_key_is_reported(self):
+        """Reading a key that was never loaded should report the miss instead of returning an empty MAS."""
+        PyMKF.clear_mas()
+        misses = PyMKF.get_mas_statistics()["misses"]
+        result = PyMKF.read_mas("never loaded")
+        assert "errorMessage" in result
+        assert PyMKF.get_mas_statistics()["misses"] == misses + 1
+        assert PyMKF.get_mas_statistics()["objects"] == 0
+
+    def test_load_and_read_magnetic(self, sample_core_data, simple_winding):
+        """A loaded magnetic should be readable by its key."""
+        PyMKF.clear_mas()
+        assert PyMKF.load_magnetic("inductor", self._magnetic(sample_core_data, simple_winding), False) == "1"
+        mas = PyMKF.read_mas("inductor")
+        assert "errorMessage" not in mas
+        assert mas["magnetic"]["core"]["functionalDescription"]["shape"] == "ETD 49/25/16"
+
+    def test_batch_load_reports_each_item(self, sample_core_data, simple_winding):
+        """A bad item in a batch should only fail itself."""
+        PyMKF.clear_mas()
+        magnetic = self._magnetic(sample_core_data, simple_winding)
+        status = PyMKF.load_magnetics_batch(["good", "bad", "also good"], [magnetic, {"core": 42}, magnetic])
+        assert status[0] == "0"
+        assert status[1] != "0"
+        assert status[2] == "0"
+        assert PyMKF.get_mas_statistics()["objects"] == 2
+        assert "errorMessage" in PyMKF.read_mas("bad")
+        assert "errorMessage" not in PyMKF.read_mas("also good")
+
+    def test_batch_matches_serial_load(self, sample_core_data, simple_winding):
+        """Magnetics built and autocompleted on worker threads should equal the same magnetics built one by one."""
+        PyMKF.clear_mas()
+        magnetics = []
+        for number_turns in range(10, 42):
+            magnetic = copy.deepcopy(self._magnetic(sample_core_data, simple_winding))
+            magnetic["coil"]["functionalDescription"][0]["numberTurns"] = number_turns
+            magnetics.append(magnetic)
+        for index, magnetic in enumerate(magnetics):
+            assert PyMKF.load_magnetic(f"serial {index}", magnetic, True).isdigit()
+        expected = [PyMKF.read_mas(f"serial {index}") for index in range(len(magnetics))]
+
+        keys = [f"parallel {index}" for index in range(len(magnetics))]
+        assert PyMKF.load_magnetics_batch(keys, magnetics, True) == ["0"] * len(magnetics)
+        assert [PyMKF.read_mas(key) for key in keys] == expected
+        PyMKF.clear_mas()
+
+    def test_memory_budget_evicts(self, sample_core_data, simple_winding):
+        """Going over the memory budget should evict objects and count the evictions."""
+        PyMKF.clear_mas()
+        magnetic = self._magnetic(sample_core_data, simple_winding)
+        for index in range(64):
+            PyMKF.load_magnetic(f"magnetic {index}", magnetic, False)
+        assert PyMKF.get_mas_statistics()["objects"] == 64
+
+        PyMKF.set_mas_memory_budget(1)
+        statistics = PyMKF.get_mas_statistics()
+        assert statistics["objects"] == 0
+        assert statistics["evictions"] >= 64
+
+        PyMKF.set_mas_memory_budget(0)
+        PyMKF.clear_mas()
+
+
+class TestMagneticsFile:
+    """Test suite for streaming magnetics files into the magnetics cache."""
+
+    def test_bad_lines_are_skipped_and_reported(self, tmp_path, sample_core_data, simple_winding):
+        """Malformed lines should be reported without stopping the load."""
+        path = tmp_path / "magnetics.ndjson"
+        with open(path, "w") as f:
+            for index in range(20):
+                magnetic = {
+                    "core": sample_core_data,
+                    "coil": {"bobbin": "Dummy", "functionalDescription": simple_winding},
+                    "manufacturerInfo": {"name": "Test", "reference": f"magnetic {index}"}
+                }
+                f.write(json.dumps(magnetic) + "\n")
+                if index == 5:
+                    f.write("{not json\n")
+
+        progress = []
+        PyMKF.clear_magnetic_cache()
+        result = PyMKF.load_magnetics_from_file(str(path), False, lambda processed, loaded, skipped: progress.append((processed, loaded, skipped)))
+        assert result == "20"
+
+        report = PyMKF.get_magnetics_file_load_report()
+        assert report["lines"] == 21
+        assert report["loaded"] == 20
+        assert report["skipped"] == 1
+        assert report["errors"][0]["line"] == 7
+        assert progress[-1] == (21, 20, 1)
+
+
+class TestAutocompleteCache:
+    """Test suite for the persistent cache of autocompleted magnetics."""
+
+    def test_second_load_hits_cache(self, tmp_path, sample_core_data, simple_winding):
+        """Loading the same magnetic twice should only autocomplete it once."""
+        magnetic = {
+            "core": sample_core_data,
+            "coil": {"bobbin": "Dummy", "functionalDescription": simple_winding}
+        }
+        assert PyMKF.set_autocomplete_cache_directory(str(tmp_path / "cache")) == "0"
+        try:
+            PyMKF.load_magnetic("first", magnetic, True)
+            PyMKF.load_magnetic("second", magnetic, True)
+            statistics = PyMKF.get_autocomplete_cache_statistics()
+            assert statistics["misses"] >= 1
+            assert statistics["hits"] >= 1
+            assert statistics["bytes"] > 0
+            assert PyMKF.read_mas("first")["magnetic"] == PyMKF.read_mas("second")["magnetic"]
+
+            assert PyMKF.clear_autocomplete_cache() == "0"
+            assert PyMKF.get_autocomplete_cache_statistics()["bytes"] == 0
+        finally:
+            PyMKF.set_autocomplete_cache_directory("")
+
+    def test_other_databases_miss_cache(self, tmp_path, sample_core_data, simple_winding):
+        """Magnetics expanded against other database contents should not be served from the cache."""
+        magnetic = {
+            "core": sample_core_data,
+            "coil": {"bobbin": "Dummy", "functionalDescription": simple_winding}
+        }
+        PyMKF.clear_databases()
+        material = PyMKF.find_core_material_by_name("3C95")
+        data = tmp_path / "data"
+        data.mkdir()
+        (data / "core_materials.ndjson").write_text(json.dumps(material) + "\n")
+        assert PyMKF.set_autocomplete_cache_directory(str(tmp_path / "cache")) == "0"
+        try:
+            PyMKF.load_magnetic("built in", magnetic, True)
+            hits = PyMKF.get_autocomplete_cache_statistics()["hits"]
+
+            assert PyMKF.read_databases(str(data), True) == "0"
+            PyMKF.load_magnetic("custom", magnetic, True)
+            assert PyMKF.get_autocomplete_cache_statistics()["hits"] == hits
+
+            PyMKF.clear_databases()
+            PyMKF.load_magnetic("built in again", magnetic, True)
+            assert PyMKF.get_autocomplete_cache_statistics()["hits"] == hits + 1
+        finally:
+            PyMKF.set_autocomplete_cache_directory("")
+            PyMKF.clear_databases()
+
+
+class TestFuzzyFind:
+    """Test suite for approximate name search."""
+
+    def test_exact_name_ranks_first(self):
+        """An existing shape name should be its own best match."""
+        name = PyMKF.get_core_shape_names(True)[0]
+        result = PyMKF.fuzzy_find("core_shape", name.lower(), 5)
+        assert result[0]["name"] == name
+        assert result[0]["score"] == pytest.approx(100)
+        assert all(a["score"] >= b["score"] for a, b in zip(result, result[1:]))
+
+    def test_typo_finds_material(self):
+        """A misspelled material should still find the intended one."""
+        result = PyMKF.fuzzy_find("core_material", "3C59", 10)
+        assert "3C95" in [match["name"] for match in result]
+
+    def test_unknown_category_returns_error(self):
+        """Unknown categories should be reported."""
+        result = PyMKF.fuzzy_find("magnet", "N87", 1)
+        assert "Exception" in result["data"]
+
+
+class TestMemoryUsage:
+    """Test suite for memory accounting."""
+
+    def test_usage_per_database(self):
+        """Every database should be reported, and the total should add them up."""
+        PyMKF.get_core_materials()
+        usage = PyMKF.get_memory_usage()
+        for name in ["coreMaterials", "coreShapes", "wires", "bobbins", "insulationMaterials",
+                     "wireMaterials", "cores", "masDatabase", "magneticsCache", "stringPool"]:
+            assert usage[name]["bytes"] >= 0
+        assert usage["coreMaterials"]["records"] > 0
+        assert usage["coreMaterials"]["bytes"] > 0
+        parts = [entry["bytes"] for name, entry in usage.items() if isinstance(entry, dict)]
+        assert usage["totalBytes"] == sum(parts)
+
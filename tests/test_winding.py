@@ -59,6 +59,39 @@ class TestWireMaterials:
             assert isinstance(material, dict)
 
 
+class TestWireLookups:
+    """Test indexed wire lookups."""
+
+    def _first_round_wire(self):
+        for wire in PyMKF.get_wires():
+            if wire.get("type") == "round" and wire.get("standardName") and "nominal" in wire.get("conductingDiameter", {}):
+                return wire
+        pytest.skip("No round wire with a standard name in the database")
+
+    def test_conducting_diameter_by_standard_name(self):
+        """Should return the diameter of the first wire with that standard name."""
+        wire = self._first_round_wire()
+        diameter = PyMKF.get_wire_conducting_diameter_by_standard_name(wire["standardName"])
+        assert diameter == pytest.approx(wire["conductingDiameter"]["nominal"])
+        assert PyMKF.get_wire_conducting_diameter_by_standard_name("not a standard name") == -1
+
+    def test_find_wire_by_dimension_picks_closest(self):
+        """Should return a round wire of the closest conducting diameter."""
+        wire = self._first_round_wire()
+        diameter = wire["conductingDiameter"]["nominal"]
+        found = PyMKF.find_wire_by_dimension(diameter * 1.001, "round", wire["standard"])
+        assert found["type"] == "round"
+        assert found["conductingDiameter"]["nominal"] == pytest.approx(diameter, rel=0.01)
+
+    def test_lookups_follow_database_reload(self):
+        """Lookups should keep working after the databases are cleared and reloaded."""
+        wire = self._first_round_wire()
+        before = PyMKF.get_wire_data_by_standard_name(wire["standardName"])
+        PyMKF.clear_databases()
+        after = PyMKF.get_wire_data_by_standard_name(wire["standardName"])
+        assert after == before
+
+
 class TestBobbins:
     """Bobbin data tests."""
 